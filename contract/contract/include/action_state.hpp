@@ -0,0 +1,376 @@
+#pragma once
+#include <eosio/eosio.hpp>
+#include <eosio/singleton.hpp>
+#include <map>
+#include <optional>
+#include <vector>
+
+using namespace eosio;
+
+// === Action State === //
+// --- Per-action cache shared by the contracts: each singleton and row is read --- //
+// --- at most once, and every change is written back once when the action ends --- //
+
+/*/
+Singleton loaded on first use and written back by flush() only if it changed
+/*/
+template <typename Singleton, typename T>
+class cached_singleton {
+public:
+  cached_singleton(name code, uint64_t scope) : _table(code, scope), _payer(code) {}
+
+  // - Whether the singleton has ever been set on chain
+  bool exists() {
+    load();
+    return _exists;
+  }
+
+  // - Stored value, or T{} when it has never been set
+  const T& get() {
+    load();
+    return *_value;
+  }
+
+  // - Mutable value, written back at flush()
+  T& modify() {
+    load();
+    _dirty = true;
+    return *_value;
+  }
+
+  // - Replaces the value, written back at flush()
+  void set(const T& value) {
+    load();
+    _value = value;
+    _dirty = true;
+  }
+
+  void flush() {
+    flush([] {});
+  }
+
+  // - Same, calling on_write() when the value is written
+  template <typename OnWrite>
+  void flush(OnWrite&& on_write) {
+    if (!_dirty) return;
+    on_write();
+    _table.set(*_value, _payer);
+    _exists = true;
+    _dirty = false;
+  }
+
+private:
+  void load() {
+    if (_value.has_value()) return;
+    _exists = _table.exists();
+    _value = _exists ? _table.get() : T{};
+  }
+
+  Singleton        _table;
+  name             _payer;
+  std::optional<T> _value;
+  bool             _exists = false;
+  bool             _dirty = false;
+};
+
+/*/
+Rows of one table scope, each read once and written back once by flush().
+Range and index reads go through table(); point reads and all writes go through the cache.
+/*/
+template <typename Table, typename Row>
+class cached_table {
+public:
+  cached_table(name code, uint64_t scope) : _table(code, scope) {}
+
+  // - Underlying handle for iteration and secondary indexes
+  Table& table() { return _table; }
+
+  // - Cached row (including unflushed changes), or nullptr when missing
+  const Row* find(uint64_t pk) {
+    auto& entry = load(pk);
+    return live(entry) ? &entry.row : nullptr;
+  }
+
+  const Row& get(uint64_t pk, const char* error_msg) {
+    const Row* row = find(pk);
+    check(row != nullptr, error_msg);
+    return *row;
+  }
+
+  // - Mutable row, written back once at flush() (payer same_payer keeps the current payer)
+  Row& modify(uint64_t pk, name payer = same_payer) {
+    auto& entry = load(pk);
+    check(live(entry), "Row not found");
+    if (entry.state == row_state::clean) entry.state = row_state::dirty;
+    if (payer != same_payer) entry.payer = payer;
+    return entry.row;
+  }
+
+  // - New row, emplaced at flush()
+  Row& emplace(name payer, Row row) {
+    auto& entry = load(row.primary_key());
+    check(!live(entry), "Row already exists");
+    entry.state = entry.state == row_state::erased ? row_state::dirty : row_state::created;
+    entry.payer = payer;
+    entry.row = std::move(row);
+    return entry.row;
+  }
+
+  // - Removes the row at flush()
+  void erase(uint64_t pk) {
+    auto& entry = load(pk);
+    check(live(entry), "Row not found");
+    entry.state = entry.state == row_state::created ? row_state::missing : row_state::erased;
+  }
+
+  void flush() {
+    flush([](uint64_t) {});
+  }
+
+  // - Same, calling on_write(pk) for each row written or erased
+  template <typename OnWrite>
+  void flush(OnWrite&& on_write) {
+    for (auto& [pk, entry] : _rows) {
+      if (entry.state != row_state::clean && entry.state != row_state::missing) on_write(pk);
+      switch (entry.state) {
+        case row_state::dirty:
+          _table.modify(_table.find(pk), entry.payer, [&](auto& row) { row = entry.row; });
+          break;
+        case row_state::created:
+          _table.emplace(entry.payer, [&](auto& row) { row = entry.row; });
+          break;
+        case row_state::erased:
+          _table.erase(_table.find(pk));
+          entry.state = row_state::missing;
+          continue;
+        default:
+          continue;
+      }
+      entry.state = row_state::clean;
+      entry.payer = same_payer;
+    }
+  }
+
+private:
+  enum class row_state : uint8_t {
+    clean,   // - Loaded, unchanged
+    missing, // - Not on chain
+    dirty,   // - Loaded and changed
+    created, // - New this action
+    erased   // - Loaded and removed this action
+  };
+
+  struct entry_t {
+    Row       row;
+    row_state state = row_state::missing;
+    name      payer = same_payer;
+  };
+
+  static bool live(const entry_t& entry) {
+    return entry.state != row_state::missing && entry.state != row_state::erased;
+  }
+
+  entry_t& load(uint64_t pk) {
+    auto cached = _rows.find(pk);
+    if (cached != _rows.end()) return cached->second;
+
+    entry_t entry;
+    auto itr = _table.find(pk);
+    if (itr != _table.end()) {
+      entry.row = *itr;
+      entry.state = row_state::clean;
+    }
+    return _rows.emplace(pk, std::move(entry)).first->second;
+  }
+
+  Table                       _table;
+  std::map<uint64_t, entry_t> _rows;
+};
+
+/*/
+Rows of one table scope kept in two layouts while they are migrated. Reads look in
+the new layout first, then the old one; changed rows are written back where they
+are, new rows go to the new layout, and migrate() moves a row across at flush().
+Keys are the old layout's. Codec maps them and converts rows:
+  std::optional<uint64_t> new_key(uint64_t pk) - key in NewTable, nullopt when no new row can have it
+  uint64_t old_key(const NewRow&)              - inverse of new_key
+  NewRow pack(const Row&) / Row unpack(const NewRow&)
+/*/
+template <typename OldTable, typename NewTable, typename Row, typename Codec>
+class versioned_table {
+public:
+  versioned_table(name code, uint64_t scope, Codec codec = Codec{})
+    : _old(code, scope), _new(code, scope), _code(code), _codec(codec) {}
+
+  // - Underlying handles for iteration and secondary indexes
+  OldTable& old_table() { return _old; }
+  NewTable& new_table() { return _new; }
+
+  // - Keys of the rows on chain in either layout (unflushed changes are not included)
+  std::vector<uint64_t> keys() {
+    std::vector<uint64_t> result;
+    for (const auto& row : _old) result.push_back(row.primary_key());
+    for (const auto& row : _new) result.push_back(_codec.old_key(row));
+    return result;
+  }
+
+  // - Chunk of a walk(): rows visited, and the key to resume from (nullopt once both layouts are done)
+  struct walk_result {
+    uint32_t                visited = 0;
+    std::optional<uint64_t> next;
+  };
+
+  // - Visits up to max rows on chain from key `from` on, both layouts merged in key order, calling
+  //   on_old(const OldRow&) or on_new(const NewRow&) straight off the iterators (unflushed changes
+  //   are not seen). Needs new_key to keep the order of keys and to map every key, as a codec
+  //   whose keys are the same in both layouts does
+  template <typename OnOld, typename OnNew>
+  walk_result walk(uint64_t from, uint32_t max, OnOld&& on_old, OnNew&& on_new) {
+    auto old_itr = _old.lower_bound(from);
+    auto new_itr = _new.lower_bound(*_codec.new_key(from));
+
+    walk_result result;
+    for (; result.visited < max; result.visited++) {
+      bool has_old = old_itr != _old.end();
+      bool has_new = new_itr != _new.end();
+      if (!has_old && !has_new) break;
+
+      if (has_old && (!has_new || old_itr->primary_key() < _codec.old_key(*new_itr))) {
+        on_old(*old_itr++);
+      } else {
+        on_new(*new_itr++);
+      }
+    }
+
+    if (old_itr != _old.end()) result.next = old_itr->primary_key();
+    if (new_itr != _new.end() && (!result.next || _codec.old_key(*new_itr) < *result.next)) result.next = _codec.old_key(*new_itr);
+    return result;
+  }
+
+  // - Cached row (including unflushed changes), or nullptr when missing
+  const Row* find(uint64_t pk) {
+    auto& entry = load(pk);
+    return entry.target != layout::none ? &entry.row : nullptr;
+  }
+
+  const Row& get(uint64_t pk, const char* error_msg) {
+    const Row* row = find(pk);
+    check(row != nullptr, error_msg);
+    return *row;
+  }
+
+  // - Mutable row, written back once at flush() (payer same_payer keeps the current payer)
+  Row& modify(uint64_t pk, name payer = same_payer) {
+    auto& entry = load(pk);
+    check(entry.target != layout::none, "Row not found");
+    entry.dirty = true;
+    if (payer != same_payer) entry.payer = payer;
+    return entry.row;
+  }
+
+  // - New row, emplaced in the new layout at flush()
+  Row& emplace(name payer, Row row) {
+    auto& entry = load(row.primary_key());
+    check(entry.target == layout::none, "Row already exists");
+    entry.target = layout::new_rows;
+    entry.dirty = true;
+    entry.payer = payer;
+    entry.row = std::move(row);
+    return entry.row;
+  }
+
+  // - Removes the row at flush()
+  void erase(uint64_t pk) {
+    auto& entry = load(pk);
+    check(entry.target != layout::none, "Row not found");
+    entry.target = layout::none;
+    entry.dirty = true;
+  }
+
+  // - Moves an old-layout row to the new layout at flush(), paid by payer;
+  //   false when the row is missing or already in the new layout
+  bool migrate(uint64_t pk, name payer) {
+    auto& entry = load(pk);
+    if (entry.target != layout::old_rows) return false;
+    entry.target = layout::new_rows;
+    entry.dirty = true;
+    entry.payer = payer;
+    return true;
+  }
+
+  void flush() {
+    flush([](uint64_t) {});
+  }
+
+  // - Same, calling on_write(pk) for each row written, moved or erased
+  template <typename OnWrite>
+  void flush(OnWrite&& on_write) {
+    for (auto& [pk, entry] : _rows) {
+      if (!entry.dirty) continue;
+      on_write(pk);
+
+      // - Leave the layout the row is moving out of (or being erased from)
+      if (entry.source == layout::old_rows && entry.target != layout::old_rows) {
+        _old.erase(_old.find(pk));
+      } else if (entry.source == layout::new_rows && entry.target != layout::new_rows) {
+        _new.erase(_new.find(*_codec.new_key(pk)));
+      }
+
+      if (entry.target == layout::old_rows) {
+        _old.modify(_old.find(pk), entry.payer, [&](auto& row) { row = entry.row; });
+      } else if (entry.target == layout::new_rows) {
+        auto packed = _codec.pack(entry.row);
+        if (entry.source == layout::new_rows) {
+          _new.modify(_new.find(packed.primary_key()), entry.payer, [&](auto& row) { row = packed; });
+        } else {
+          _new.emplace(entry.payer == same_payer ? _code : entry.payer, [&](auto& row) { row = packed; });
+        }
+      }
+
+      entry.source = entry.target;
+      entry.dirty = false;
+      entry.payer = same_payer;
+    }
+  }
+
+private:
+  enum class layout : uint8_t {
+    none,     // - Not on chain (missing or erased)
+    old_rows, // - Stored in OldTable
+    new_rows  // - Stored in NewTable
+  };
+
+  struct entry_t {
+    Row    row;
+    layout source = layout::none; // - Where the row is on chain
+    layout target = layout::none; // - Where flush() leaves it
+    bool   dirty = false;
+    name   payer = same_payer;
+  };
+
+  entry_t& load(uint64_t pk) {
+    auto cached = _rows.find(pk);
+    if (cached != _rows.end()) return cached->second;
+
+    entry_t entry;
+    std::optional<uint64_t> new_pk = _codec.new_key(pk);
+    auto itr = new_pk.has_value() ? _new.find(*new_pk) : _new.end();
+    if (itr != _new.end()) {
+      entry.row = _codec.unpack(*itr);
+      entry.source = entry.target = layout::new_rows;
+    } else {
+      auto old_itr = _old.find(pk);
+      if (old_itr != _old.end()) {
+        entry.row = *old_itr;
+        entry.source = entry.target = layout::old_rows;
+      }
+    }
+    return _rows.emplace(pk, std::move(entry)).first->second;
+  }
+
+  OldTable                    _old;
+  NewTable                    _new;
+  name                        _code;
+  Codec                       _codec;
+  std::map<uint64_t, entry_t> _rows;
+};
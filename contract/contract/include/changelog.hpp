@@ -0,0 +1,135 @@
+#pragma once
+#include <eosio/eosio.hpp>
+#include <eosio/singleton.hpp>
+#include <optional>
+#include <vector>
+#include "instrumentation.hpp"
+
+using namespace eosio;
+
+// === Change Log === //
+// --- Bounded feed of changed rows under a sequence number that only grows, so an --- //
+// --- indexer polls what changed since its last seq instead of re-reading every table --- //
+
+namespace changelog {
+
+  // - What an entry points at; the indexer re-reads that row (gone means erased)
+  enum kind : uint8_t {
+    ADOPTER = 1, // - account: the adopter
+    STAKE   = 2, // - account: the staker, key: staked symbol code
+    REWARD  = 3, // - account: the staker, key: id of the ledger row
+    CONFIG  = 4  // - key: staked symbol code (stakepurple), 0 for the singleton (invitono)
+  };
+
+  // - Largest page changes() returns
+  constexpr uint32_t MAX_PAGE = 1000;
+
+  // - Entries past the retention erased by each append, so a lowered retention converges
+  constexpr uint32_t TRIM_PER_APPEND = 2;
+
+  // - Entries past the retention erased by set_retention itself
+  constexpr uint32_t TRIM_PER_SET = 1000;
+
+}
+
+/*/
+One change. Entries are contiguous from log_state::first_seq to next_seq - 1
+/*/
+TABLE change_entry {
+  uint64_t seq;     // - Position in the feed, from 1
+  uint8_t  kind;    // - changelog::kind
+  name     account;
+  uint64_t key = 0;
+  uint32_t at;      // - Block time of the change
+
+  uint64_t primary_key() const { return seq; }
+};
+
+using changes_table = multi_index<"changes"_n, change_entry>;
+
+TABLE log_state {
+  uint64_t first_seq = 1; // - Oldest entry kept
+  uint64_t next_seq = 1;  // - Sequence of the next entry
+  uint32_t retention = 0; // - Entries kept; 0 turns the log off
+};
+
+using logstate_table = singleton<"logstate"_n, log_state>;
+
+struct change_page {
+  std::vector<change_entry> changes;
+  uint64_t                  first_seq; // - Oldest kept: since_seq + 1 below it means entries were trimmed, resync
+  uint64_t                  next_seq;  // - Pass next_seq - 1 as since_seq to poll for what follows
+  bool                      more = false;
+};
+
+/*/
+Appends, trims and reads the change log of one contract. The state singleton is
+read on the first append or read of an action and written back once by flush()
+/*/
+class change_log {
+public:
+  change_log(name code) : _entries(code, code.value), _state(code, code.value), _code(code) {}
+
+  // - Appends one entry and trims what falls out of the retention; nothing while the log is off
+  void append(uint8_t kind, name account, uint64_t key = 0) {
+    load();
+    if (_value->retention == 0) return;
+
+    uint64_t seq = _value->next_seq++;
+    uint32_t now = current_time_point().sec_since_epoch();
+    _entries.emplace(_code, [&](auto& row) {
+      row.seq = seq;
+      row.kind = kind;
+      row.account = account;
+      row.key = key;
+      row.at = now;
+    });
+    trim(changelog::TRIM_PER_APPEND);
+    _dirty = true;
+  }
+
+  // - New retention (0 turns the log off); entries past it are trimmed here, then by appends
+  void set_retention(uint32_t retention) {
+    load();
+    _value->retention = retention;
+    trim(changelog::TRIM_PER_SET);
+    _dirty = true;
+  }
+
+  // - Up to max entries after since_seq, oldest first
+  change_page read(uint64_t since_seq, uint32_t max) {
+    load();
+    change_page page{{}, _value->first_seq, _value->next_seq};
+    auto itr = _entries.lower_bound(since_seq + 1);
+    for (; itr != _entries.end() && page.changes.size() < max; ++itr) {
+      page.changes.push_back(*itr);
+    }
+    page.more = itr != _entries.end();
+    return page;
+  }
+
+  void flush() {
+    if (!_dirty) return;
+    _state.set(*_value, _code);
+    _dirty = false;
+  }
+
+private:
+  void load() {
+    if (_value.has_value()) return;
+    _value = _state.exists() ? _state.get() : log_state{};
+  }
+
+  void trim(uint32_t limit) {
+    for (uint32_t n = 0; n < limit && _value->next_seq - _value->first_seq > _value->retention; n++) {
+      _entries.erase(_entries.find(_value->first_seq));
+      _value->first_seq++;
+    }
+  }
+
+  counted_t<changes_table>  _entries;
+  counted_t<logstate_table> _state;
+  name                      _code;
+  std::optional<log_state>  _value;
+  bool                      _dirty = false;
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// === Figurate Numbers === //
+// --- Triangular and tetrahedral series built at compile time, shared by the contracts --- //
+
+namespace figurate {
+
+  // - n-th triangular number, n(n+1)/2 (triangular(1) = 1)
+  constexpr uint64_t triangular(uint64_t n) {
+    return n * (n + 1) / 2;
+  }
+
+  // - n-th tetrahedral number, n(n+1)(n+2)/6 (tetrahedral(1) = 1)
+  constexpr uint64_t tetrahedral(uint64_t n) {
+    return n * (n + 1) / 2 * (n + 2) / 3;
+  }
+
+  // - First N triangular numbers, triangular(1)..triangular(N)
+  template <size_t N>
+  constexpr std::array<uint64_t, N> triangular_series() {
+    std::array<uint64_t, N> series{};
+    for (size_t i = 0; i < N; i++) series[i] = triangular(i + 1);
+    return series;
+  }
+
+  // - First N tetrahedral numbers, tetrahedral(1)..tetrahedral(N)
+  template <size_t N>
+  constexpr std::array<uint64_t, N> tetrahedral_series() {
+    std::array<uint64_t, N> series{};
+    for (size_t i = 0; i < N; i++) series[i] = tetrahedral(i + 1);
+    return series;
+  }
+
+  // - How many terms of an increasing series are <= value (binary search), so
+  //   a series of N terms yields levels 0..N
+  template <size_t N>
+  constexpr size_t level(const std::array<uint64_t, N>& series, uint64_t value) {
+    size_t low = 0, high = N;
+    while (low < high) {
+      size_t mid = low + (high - low) / 2;
+      if (series[mid] <= value) low = mid + 1;
+      else high = mid;
+    }
+    return low;
+  }
+
+  // - Each tetrahedral number adds the next triangular one, and both series increase
+  template <size_t N>
+  constexpr bool check_series() {
+    constexpr auto tri = triangular_series<N>();
+    constexpr auto tet = tetrahedral_series<N>();
+    if (tri[0] != 1 || tet[0] != 1) return false;
+    for (size_t i = 1; i < N; i++) {
+      if (tri[i] != tri[i - 1] + i + 1) return false;
+      if (tet[i] != tet[i - 1] + tri[i]) return false;
+    }
+    return true;
+  }
+
+  static_assert(check_series<64>(), "Figurate series are inconsistent");
+  static_assert(tetrahedral(24) == 2600 && tetrahedral(36) == 8436, "Unexpected tetrahedral values");
+  static_assert(triangular(28) == 406, "Unexpected triangular value");
+  static_assert(level(tetrahedral_series<24>(), 0) == 0 && level(tetrahedral_series<24>(), 1) == 1 &&
+                level(tetrahedral_series<24>(), 2599) == 23 && level(tetrahedral_series<24>(), 2600) == 24 &&
+                level(tetrahedral_series<24>(), UINT64_MAX) == 24, "Level lookup is off");
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+// === Fixed-Point Math === //
+// --- Integer reward arithmetic shared by the contracts: no floats, checked, rounding chosen by the caller --- //
+
+namespace fixed_point {
+
+  using uint128 = unsigned __int128;
+
+  // - Largest asset amount, the same bound as eosio::asset::max_amount
+  constexpr int64_t MAX_AMOUNT = (int64_t(1) << 62) - 1;
+
+  // - Symbol precision is at most 18, and 10^18 is the largest power of 10 in 64 bits
+  constexpr uint8_t MAX_PRECISION = 18;
+
+  enum class rounding : uint8_t {
+    down,    // - Toward zero, the default for anything paid out
+    up,      // - Away from zero on any remainder
+    nearest  // - Half rounds up
+  };
+
+  // - 10^0..10^18, built at compile time
+  constexpr std::array<uint64_t, MAX_PRECISION + 1> pow10_table() {
+    std::array<uint64_t, MAX_PRECISION + 1> table{};
+    table[0] = 1;
+    for (size_t i = 1; i < table.size(); i++) table[i] = table[i - 1] * 10;
+    return table;
+  }
+
+  constexpr auto POW10 = pow10_table();
+
+  // - 10^exp, or nothing past MAX_PRECISION
+  constexpr std::optional<uint64_t> pow10(uint8_t exp) {
+    if (exp > MAX_PRECISION) return std::nullopt;
+    return POW10[exp];
+  }
+
+  // - a * b, or nothing when it does not fit 128 bits
+  constexpr std::optional<uint128> mul(uint128 a, uint128 b) {
+    if (a != 0 && b > ~uint128(0) / a) return std::nullopt;
+    return a * b;
+  }
+
+  // - n / d rounded as asked, or nothing when d is zero
+  constexpr std::optional<uint128> div(uint128 n, uint128 d, rounding mode = rounding::down) {
+    if (d == 0) return std::nullopt;
+    uint128 quotient = n / d;
+    uint128 remainder = n % d;
+    if (mode == rounding::up && remainder != 0) quotient++;
+    if (mode == rounding::nearest && remainder >= d - remainder) quotient++;
+    return quotient;
+  }
+
+  // - a * b / d with the full 128-bit product, so nothing is lost to dividing first
+  constexpr std::optional<uint128> mul_div(uint128 a, uint128 b, uint128 d, rounding mode = rounding::down) {
+    std::optional<uint128> product = mul(a, b);
+    if (!product.has_value()) return std::nullopt;
+    return div(*product, d, mode);
+  }
+
+  // - Whole tokens to units of a symbol with that precision
+  constexpr std::optional<uint128> to_units(uint128 whole, uint8_t precision) {
+    std::optional<uint64_t> scale = pow10(precision);
+    if (!scale.has_value()) return std::nullopt;
+    return mul(whole, *scale);
+  }
+
+  // - Units of a symbol with that precision to whole tokens
+  constexpr std::optional<uint128> to_whole(uint128 units, uint8_t precision, rounding mode = rounding::down) {
+    std::optional<uint64_t> scale = pow10(precision);
+    if (!scale.has_value()) return std::nullopt;
+    return div(units, *scale, mode);
+  }
+
+  // - A result as an asset amount, or nothing past MAX_AMOUNT (a missing input stays missing)
+  constexpr std::optional<int64_t> to_amount(std::optional<uint128> value) {
+    if (!value.has_value() || *value > uint128(MAX_AMOUNT)) return std::nullopt;
+    return static_cast<int64_t>(*value);
+  }
+
+  static_assert(POW10[0] == 1 && POW10[4] == 10000 && POW10[18] == 1000000000000000000ull, "Power of 10 table is off");
+  static_assert(!pow10(19).has_value(), "Precision past 18 must be rejected");
+  static_assert(*mul_div(7, 150, 100) == 10 && *mul_div(7, 150, 100, rounding::up) == 11 &&
+                *mul_div(7, 150, 100, rounding::nearest) == 11 && *mul_div(5, 1, 10, rounding::nearest) == 1 &&
+                *mul_div(4, 1, 10, rounding::nearest) == 0, "Rounding is off");
+  static_assert(!mul(~uint128(0), 2).has_value() && !div(1, 0).has_value(), "Overflow and zero division must be rejected");
+
+}
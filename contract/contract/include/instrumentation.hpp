@@ -0,0 +1,181 @@
+#pragma once
+#include <eosio/eosio.hpp>
+#include <eosio/singleton.hpp>
+#include <utility>
+
+using namespace eosio;
+
+// === Instrumentation === //
+// --- Opt-in per-action counts of database operations and inline actions. Built with --- //
+// --- -DCONTRACT_INSTRUMENTATION; otherwise counted_t<Table> is Table and every hook is empty --- //
+
+namespace instrumentation {
+
+  /*/
+  Operations issued by one action, printed to its console by report() as
+  instrumentation:{"finds":..,"secondary_updates":..,...}
+  /*/
+  struct action_counts {
+    uint32_t finds = 0;             // - Primary lookups: find, get, lower_bound, upper_bound, begin, singleton reads
+    uint32_t secondary_updates = 0; // - Secondary keys stored, re-keyed or removed
+    uint32_t emplaces = 0;
+    uint32_t modifies = 0;
+    uint32_t erases = 0;
+    uint32_t inline_actions = 0;
+  };
+
+#ifdef CONTRACT_INSTRUMENTATION
+
+  inline action_counts& counts() {
+    static action_counts current;
+    return current;
+  }
+
+  // - Call after each inline action is sent
+  inline void inline_sent() { counts().inline_actions++; }
+
+  // - Prints this action's counts (call last, after the write-back) and starts the next action from zero
+  inline void report() {
+    const action_counts& c = counts();
+    print("instrumentation:{\"finds\":", c.finds, ",\"secondary_updates\":", c.secondary_updates,
+          ",\"emplaces\":", c.emplaces, ",\"modifies\":", c.modifies, ",\"erases\":", c.erases,
+          ",\"inline_actions\":", c.inline_actions, "}");
+    counts() = {};
+  }
+
+  template <typename Table>
+  class counted;
+
+  /*/
+  multi_index that counts each call before passing it on; a modify counts
+  one secondary update per index whose key changed, as the chain bills it
+  /*/
+  template <name::raw TableName, typename T, typename... Indices>
+  class counted<multi_index<TableName, T, Indices...>> : public multi_index<TableName, T, Indices...> {
+    using base = multi_index<TableName, T, Indices...>;
+
+  public:
+    using base::base;
+    using typename base::const_iterator;
+
+    const_iterator begin() const {
+      counts().finds++;
+      return base::begin();
+    }
+
+    const_iterator find(uint64_t pk) const {
+      counts().finds++;
+      return base::find(pk);
+    }
+
+    const_iterator lower_bound(uint64_t pk) const {
+      counts().finds++;
+      return base::lower_bound(pk);
+    }
+
+    const_iterator upper_bound(uint64_t pk) const {
+      counts().finds++;
+      return base::upper_bound(pk);
+    }
+
+    const T& get(uint64_t pk, const char* error_msg = "unable to find key") const {
+      counts().finds++;
+      return base::get(pk, error_msg);
+    }
+
+    template <typename Lambda>
+    const_iterator emplace(name payer, Lambda&& constructor) {
+      counts().emplaces++;
+      counts().secondary_updates += sizeof...(Indices);
+      return base::emplace(payer, std::forward<Lambda>(constructor));
+    }
+
+    template <typename Lambda>
+    void modify(const_iterator itr, name payer, Lambda&& updater) {
+      T before = *itr;
+      base::modify(itr, payer, std::forward<Lambda>(updater));
+      counts().modifies++;
+      counts().secondary_updates += changed_keys(before, *itr);
+    }
+
+    template <typename Lambda>
+    void modify(const T& obj, name payer, Lambda&& updater) {
+      T before = obj;
+      base::modify(obj, payer, std::forward<Lambda>(updater));
+      counts().modifies++;
+      counts().secondary_updates += changed_keys(before, obj);
+    }
+
+    const_iterator erase(const_iterator itr) {
+      counts().erases++;
+      counts().secondary_updates += sizeof...(Indices);
+      return base::erase(itr);
+    }
+
+    void erase(const T& obj) {
+      counts().erases++;
+      counts().secondary_updates += sizeof...(Indices);
+      base::erase(obj);
+    }
+
+  private:
+    static uint32_t changed_keys(const T& before, const T& after) {
+      return (0u + ... + (typename Indices::secondary_extractor_type()(before) != typename Indices::secondary_extractor_type()(after) ? 1u : 0u));
+    }
+  };
+
+  /*/
+  singleton that counts each read as a find and each write as an emplace or modify
+  /*/
+  template <name::raw SingletonName, typename T>
+  class counted<singleton<SingletonName, T>> : public singleton<SingletonName, T> {
+    using base = singleton<SingletonName, T>;
+
+  public:
+    using base::base;
+
+    bool exists() {
+      counts().finds++;
+      return base::exists();
+    }
+
+    T get() {
+      counts().finds++;
+      return base::get();
+    }
+
+    T get_or_default(const T& def = T()) {
+      counts().finds++;
+      return base::get_or_default(def);
+    }
+
+    void set(const T& value, name payer) {
+      counts().finds++;
+      if (base::exists()) counts().modifies++;
+      else counts().emplaces++;
+      base::set(value, payer);
+    }
+
+    void remove() {
+      counts().finds++;
+      if (base::exists()) counts().erases++;
+      base::remove();
+    }
+  };
+
+  template <typename Table>
+  using counted_t = counted<Table>;
+
+#else
+
+  inline void inline_sent() {}
+  inline void report() {}
+
+  template <typename Table>
+  using counted_t = Table;
+
+#endif
+
+}
+
+using instrumentation::counted_t;
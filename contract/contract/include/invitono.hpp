@@ -4,6 +4,14 @@
 #include <eosio/time.hpp>
 #include <eosio/singleton.hpp>
 #include <eosio/permission.hpp> 
+#include <eosio/binary_extension.hpp>
+#include <map>
+#include "action_state.hpp"
+#include "instrumentation.hpp"
+#include "figurate.hpp"
+#include "fixed_point.hpp"
+#include "snapshot.hpp"
+#include "changelog.hpp"
 
 using namespace eosio;
 using std::string;
@@ -13,7 +21,10 @@ using std::string;
 
 CONTRACT invitono : public contract {
 public:
-  using contract::contract;
+  invitono(name receiver, name code, datastream<const char*> ds);
+
+  // - Writes back every row and singleton the action changed
+  ~invitono();
 
   // === User Actions === //
   // --- Core user interactions --- //
@@ -21,6 +32,15 @@ public:
   // - Register new user with invite code
   ACTION registeruser(name user, name inviter);
 
+  // - One (user, inviter) pair of a batch registration
+  struct registration {
+    name user;    // - Account being registered
+    name inviter; // - Registered account (or earlier batch entry) that invited them
+  };
+
+  // - Register many users in one transaction (contract or admin only)
+  ACTION registerbatch(std::vector<registration> registrations);
+
   // - Claim rewards based on score
   ACTION claimreward(name user);
 
@@ -40,6 +60,68 @@ public:
   // - Development utility action
   ACTION deleteuser(name user);
 
+  // - Admin fills the stored upline of rows registered before it existed
+  ACTION backfill(name from, uint32_t max_rows);
+
+  // - Admin picks lazy propagation and how many upline levels run inline
+  ACTION setmode(bool lazy_scores, uint16_t inline_levels);
+
+  // - Anyone applies up to max_items queued credits to their upline
+  ACTION crank(uint32_t max_items);
+
+  // - Admin sets how many change log entries are kept (0 turns the log off)
+  ACTION setlog(uint32_t retention);
+
+  // - Read-only page of up to max change log entries after since_seq (adopters and config)
+  [[eosio::action, eosio::read_only]] change_page changes(uint64_t since_seq, uint32_t max);
+
+  // - Read-only score including credits still waiting in the queue (fails while more than
+  //   PENDING_READ_LIMIT are queued)
+  [[eosio::action, eosio::read_only]] uint32_t getscore(name user);
+
+  // - Admin moves up to max_rows adopters to the compact layout, resuming at the stored cursor;
+  //   returns the rows moved
+  [[eosio::action]] uint32_t migrate(uint32_t max_rows);
+
+  // - Admin adds adopters registered before referral counts existed to their upline's counts
+  ACTION recount(name from, uint32_t max_rows);
+
+  // - Anyone advances the leaderboard rebuild by up to max_rows rows; returns the rows processed
+  [[eosio::action]] uint32_t refreshlb(uint32_t max_rows);
+
+  // - Admin turns up to max_rows claimed, idle adopters from cursor on into tombstones without a
+  //   stored path; returns the rows pruned and prints the next cursor
+  [[eosio::action]] uint32_t prune(uint32_t max_rows, name cursor);
+
+  // === Referral Counts === //
+  // --- Per-adopter downline totals, kept current as adopters register --- //
+
+  /*/
+  direct and downline grow on the same walk that credits scores, so in lazy mode
+  they catch up when crank applies the queued credit. downline covers the levels
+  up to max_referral_depth at the time each adopter was counted. The counts are
+  fixed-width so counting never lengthens a row that already has them, and an
+  ancestor's row keeps its payer
+  /*/
+  struct referral_counts {
+    uint32_t direct = 0;          // - Adopters invited by this account
+    uint32_t downline = 0;        // - Adopters below this account, every counted level
+    bool     counted = false;     // - This row is already in its own upline's counts
+  };
+
+  // === Upline Path === //
+  // --- Ancestors stored on an adopter row so walks skip pointer chasing --- //
+
+  /*/
+  Every write stores a row's extensions, unset ones as their defaults, so a
+  row from before paths were stored reads back with an empty path after any
+  other write. filled tells the two apart: it is only set with the path
+  /*/
+  struct upline_path {
+    std::vector<name> ancestors;      // - Above invitedby, nearest first (bounded)
+    bool              filled = false; // - ancestors is the row's path (unset until backfill or migrate fills it)
+  };
+
   // === Adopter Table === //
   // --- Tracks registered users and referral statistics --- //
 
@@ -52,6 +134,8 @@ public:
     uint32_t    lastupdated;      // - Last score update timestamp
     uint32_t    score = 0;        // - Current referral score
     bool        claimed = false;  // - Reward claim status
+    binary_extension<upline_path> upline; // - Missing or not filled on rows registered before paths were stored
+    binary_extension<referral_counts> referrals; // - Missing on rows registered before counts existed
 
     uint64_t primary_key() const { return account.value; }
     uint64_t by_score() const { return static_cast<uint64_t>(UINT32_MAX - score); } // - Sort descending
@@ -61,6 +145,97 @@ public:
     indexed_by<"byscore"_n, const_mem_fun<adopter, uint64_t, &adopter::by_score>>
   >;
 
+  // === Compact Adopter Table === //
+  // --- Adopter rows in the v2 layout, 21 bytes before the upline instead of 25 --- //
+
+  /*/
+  Same data as adopter: claimed shares a word with lastupdated (kept relative to
+  CONTRACT_EPOCH) and score is a varuint, one byte below 128. New rows are stored
+  here; adopter rows move here through migrate and are read from both meanwhile.
+  There is no score index: credits rewrite only the row, and the ranking is the
+  snapshot refreshlb rebuilds. Rows pruned to tombstones keep an empty upline and
+  set the pruned bit, and are walked through invitedby like legacy rows without a path
+  /*/
+  TABLE adopter_v2 {
+    name              account;   // - WAX account name
+    name              invitedby; // - Referrer account
+    uint32_t          packed;    // - Bit 31: claimed, bit 30: pruned, bits 0-29: lastupdated - CONTRACT_EPOCH
+    unsigned_int      score;     // - Current referral score
+    std::vector<name> upline;    // - Ancestors above invitedby, filled unless pruned
+    binary_extension<referral_counts> referrals; // - Missing on rows registered before counts existed
+
+    uint64_t primary_key() const { return account.value; }
+    uint128_t by_inviter() const { return inviter_key(invitedby, account); } // - Direct referrals, by account
+
+    // - Inviter in the high half, account in the low half, so one inviter's referrals are a contiguous range
+    static uint128_t inviter_key(name inviter, name account) {
+      return (static_cast<uint128_t>(inviter.value) << 64) | account.value;
+    }
+  };
+
+  using adopters2_table = multi_index<"adopters2"_n, adopter_v2,
+    indexed_by<"byinviter"_n, const_mem_fun<adopter_v2, uint128_t, &adopter_v2::by_inviter>>
+  >;
+
+  // - Converts between the layouts for versioned_table; both are keyed by account
+  struct adopter_codec {
+    static std::optional<uint64_t> new_key(uint64_t pk) { return pk; }
+    static uint64_t old_key(const adopter_v2& row) { return row.account.value; }
+    static adopter_v2 pack(const adopter& row);
+    static adopter unpack(const adopter_v2& row);
+  };
+
+  // === Migration Singleton === //
+  // --- Progress of migrate through the adopter table --- //
+
+  TABLE migration {
+    name cursor;       // - First adopter the next chunk visits
+    bool done = false; // - Every adopter row is in the compact layout
+  };
+
+  using migration_table = singleton<"migration"_n, migration>;
+
+  // === Leaderboard Snapshot === //
+  // --- Top LEADERBOARD_SIZE adopters as of the last completed refreshlb pass --- //
+
+  /*/
+  Two copies live in scopes 0 and 1: leaderboard reads the live one while
+  refreshlb clears the other and refills it one chunk of adopters at a time,
+  then swaps. Scores are the stored ones; lazy credits count once cranked
+  /*/
+  TABLE leader {
+    name     account;
+    uint32_t score;
+
+    uint64_t primary_key() const { return account.value; }
+    uint128_t by_score() const { return score_key(score, account); } // - Sort descending, ties by account
+
+    // - Score descending in the high half, account in the low half, so a (score, account) cursor is one key
+    static uint128_t score_key(uint32_t score, name account) {
+      return (static_cast<uint128_t>(UINT32_MAX - score) << 64) | account.value;
+    }
+  };
+
+  using leaderboard_table = multi_index<"leaderboard"_n, leader,
+    indexed_by<"byscore"_n, const_mem_fun<leader, uint128_t, &leader::by_score>>
+  >;
+
+  struct leaderboard_page {
+    std::vector<leader> leaders;
+    bool                more = false; // - Rows remain after this page
+  };
+
+  // - Progress of the rebuild
+  TABLE lbstate {
+    uint64_t live = 0;        // - Scope leaderboard reads
+    bool     filling = false; // - The other scope is cleared and being refilled
+    name     cursor;          // - Next adopter the refill visits
+    uint32_t size = 0;        // - Rows in the scope being refilled
+    uint32_t refreshed = 0;   // - When the live scope was completed
+  };
+
+  using lbstate_table = singleton<"lbstate"_n, lbstate>;
+
   // === Config Singleton === //
   // --- Contract configuration values --- //
 
@@ -77,10 +252,63 @@ public:
     name     token_contract;             // - Token contract account
     symbol   reward_symbol;              // - Reward token symbol
     uint32_t reward_rate = 100;          // - Tokens per point (100 = 1.00 token)
+    binary_extension<bool> lazy_scores;  // - Queue credits instead of walking the upline inline
+    binary_extension<uint16_t> inline_levels; // - Levels credited inline before the rest is queued (0 = all)
   };
 
   using config_table = singleton<"config"_n, config>;
 
+  // === Read-Only Queries === //
+  // --- One-call views for the frontend --- //
+
+  // - Everything the invite page shows for one adopter
+  struct user_summary {
+    name     account;
+    uint32_t score;              // - Including credits still queued
+    bool     claimed;
+    uint32_t cooldown_remaining; // - Seconds until the score can be credited again
+    uint32_t position;           // - Tetrahedral position of the score
+    asset    reward;             // - Claimable now (zero once claimed)
+    uint32_t direct;             // - Adopters invited by this account
+    uint32_t downline;           // - Adopters below this account, up to max_referral_depth
+    bool     settled;            // - Every queued credit is included (false while more than PENDING_READ_LIMIT are queued)
+  };
+
+  // - Read-only summary of one adopter in a single call
+  [[eosio::action, eosio::read_only]] user_summary getuser(name user);
+
+  // - Read-only page of up to limit snapshot rows by score, highest first and ties by account,
+  //   after the (after_score, after_account) cursor; an empty after_account starts at the top
+  [[eosio::action, eosio::read_only]] leaderboard_page leaderboard(uint32_t after_score, name after_account, uint32_t limit);
+
+  // - One direct referral with its own counts
+  struct referral {
+    name     account;
+    uint32_t score;
+    uint32_t direct;
+    uint32_t downline;
+  };
+
+  struct referral_page {
+    std::vector<referral> referrals;
+    bool                  more = false; // - Rows remain after this page
+  };
+
+  // - Read-only page of up to limit adopters invited by inviter, by account, after the after cursor;
+  //   only the compact layout is indexed, so rows still in the old layout are listed once migrated
+  [[eosio::action, eosio::read_only]] referral_page getreferrals(name inviter, name after, uint32_t limit);
+
+  // - One page of the adopter export; rows holds snapshot::adopter_record entries in account order
+  struct export_page {
+    std::vector<char> rows;
+    uint64_t          cursor = 0;     // - Opaque, passed back to resume after this page
+    bool              more = false;   // - Rows remain after this page
+    bool              settled = true; // - No credits queued, so stored scores are final
+  };
+
+  // - Read-only export of up to limit adopters from both layouts, starting at cursor (0 starts at the first)
+  [[eosio::action, eosio::read_only]] export_page exportadopt(uint64_t cursor, uint32_t limit);
+
   // === Stats Singleton === //
   // --- Global contract statistics --- //
 
@@ -95,27 +323,160 @@ public:
 
   using stats_table = singleton<"stats"_n, stats>;
 
+  // === Stats Shards === //
+  // --- Registration counters split by user name hash --- //
+
+  /*/
+  Registrations add to one shard instead of rewriting the stats singleton; the
+  singleton keeps the totals from before sharding and getstats() adds the shards to it
+  /*/
+  TABLE stat_shard {
+    uint64_t id;                  // - Shard number (0..STATS_SHARDS-1)
+    uint64_t total_referrals = 0; // - Referral connections counted in this shard
+    uint64_t total_users = 0;     // - Users counted in this shard
+    name     last_registered;     // - Most recent registration in this shard
+    uint32_t last_registered_at = 0; // - When last_registered signed up
+
+    uint64_t primary_key() const { return id; }
+  };
+
+  using statshards_table = multi_index<"statshards"_n, stat_shard>;
+
+  // - Read-only totals: the stats singleton plus every shard
+  [[eosio::action, eosio::read_only]] stats getstats();
+
+  // === Credits Table === //
+  // --- Registrations whose upline credit has not been applied yet --- //
+
+  /*/
+  One row per queued registration (or the unfinished remainder of one), applied in id order by crank
+  /*/
+  TABLE credit {
+    uint64_t id;             // - Queue position
+    name     inviter;        // - Direct inviter of the registration
+    uint32_t created;        // - Registration time, cooldowns are judged against it
+    uint16_t from_level = 1; // - First upline level still owed (1 = inviter)
+
+    uint64_t primary_key() const { return id; }
+  };
+
+  using credits_table = multi_index<"credits"_n, credit>;
+
 private:
   // === Internal Functions === //
   // --- Core business logic --- //
 
-  // - Updates scores for inviter and their upline
-  void update_scores(name direct_inviter);
+  // - Updates scores and referral counts on levels first_level..last_level as of time `at`;
+  //   returns true when a level beyond last_level is still owed
+  bool update_scores(name direct_inviter, uint32_t at, uint16_t first_level = 1, uint16_t last_level = UINT16_MAX);
+
+  // - Validates and records one registration (shared by single and batch)
+  void add_adopter(name user, name inviter, name payer);
+
+  // - Applies the credit inline up to the level budget and queues the remainder
+  void credit_upline(name direct_inviter, uint32_t at);
+
+  // - Queues the levels from from_level up of one registration's credit, one row whatever the depth
+  void queue_credit(name direct_inviter, uint32_t at, uint16_t from_level);
+
+  // - Applies up to max_items queued credits, oldest first; returns the number applied
+  uint32_t apply_credits(uint32_t max_items);
+
+  // - Applies to current the queued credits that reach it, without writing anything; replays at
+  //   most PENDING_READ_LIMIT credits and returns false when more are queued
+  bool with_pending(adopter& current);
+
+  // - Adds one adopter to an ancestor's counts at the given level
+  static void count_downline(adopter& ancestor, uint16_t level);
+
+  // - Payer for a write to another adopter's row: the contract only when the write makes it longer
+  name growth_payer(const adopter& before, const adopter& after) const;
+
+  // - Whether the row carries its upline path (false on legacy rows not yet filled, and on tombstones)
+  static bool has_path(const adopter& row) { return row.upline.has_value() && row.upline->filled; }
+
+  // - Tokens paid for a tetrahedral position
+  asset reward_for(uint32_t position, const config& cfg);
+
+  // - Visits each ancestor credited by one registration, from first_level up
+  template <typename Visitor>
+  void walk_upline(name direct_inviter, uint16_t max_depth, uint16_t first_level, Visitor&& visit);
+
+  // - Builds the stored upline for a new child of inviter
+  std::vector<name> child_upline(const adopter& inviter, uint16_t max_depth);
+
+  // - Enforces the configured minimum account age
+  void check_account_age(name user, const config& cfg);
+
+  // - Counts `count` registrations ending with `user` in user's stats shard
+  void count_registrations(name user, uint64_t count);
+
+  // - Upline path for a row registered before paths were stored
+  std::vector<name> backfill_upline(const adopter& row);
 
   // === Constants === //
+  // --- Compact layout --- //
+
+  // - Start of the relative timestamps in adopter_v2 (2024-01-01 00:00:00 UTC)
+  static constexpr uint32_t CONTRACT_EPOCH = 1704067200;
+
+  // - Claimed flag in adopter_v2::packed, below it the timestamp
+  static constexpr uint32_t CLAIMED_BIT = 1u << 31;
+
+  // - Pruned flag in adopter_v2::packed: the upline was dropped and is read as missing
+  static constexpr uint32_t PRUNED_BIT = 1u << 30;
+
+  // - Bytes a varuint takes, one per 7 bits of the value
+  static constexpr uint32_t varuint_size(uint32_t value) {
+    uint32_t size = 1;
+    while (value >>= 7) size++;
+    return size;
+  }
+
+  // --- Credit queue --- //
+
+  // - Queued credits a view replays, a walk each, so reads stay bounded however long the queue grows
+  static constexpr uint32_t PENDING_READ_LIMIT = 25;
+
+  // - Queued credits claimreward applies before replaying the rest
+  static constexpr uint32_t CLAIM_CRANK_ITEMS = 5;
+
+  // - Claimed adopters not credited for this long are pruned
+  static constexpr uint32_t PRUNE_IDLE_SECONDS = 90 * 24 * 3600;
+
+  // - Largest leaderboard and referral page
+  static constexpr uint32_t MAX_LEADERBOARD_PAGE = 100;
+
+  // - Rows kept in the leaderboard snapshot
+  static constexpr uint32_t LEADERBOARD_SIZE = 1000;
+
+  // --- Stats sharding --- //
+
+  static constexpr uint64_t STATS_SHARDS = 16;
+
+  // - Shard for a user; names are hashed since their low bits are mostly padding
+  static constexpr uint64_t stats_shard_of(name user) {
+    return (user.value * 0x9E3779B97F4A7C15ULL) >> 60;
+  }
+
   // --- Tetrahedral series values --- //
 
-  // - Pre-calculated tetrahedral series values
-  const std::vector<uint32_t> TETRAHEDRAL = {1, 4, 10, 20, 35, 56, 84, 120, 165, 220, 286, 364, 455, 560, 680, 816, 969, 1140, 1330, 1540, 1771, 2024, 2300, 2600, 999999999};
+  // - Tetrahedral series up to the highest rewarded position, built at compile time
+  static constexpr auto TETRAHEDRAL = figurate::tetrahedral_series<24>();
 
   // - Calculates position in tetrahedral series
-  uint32_t calculate_tetrahedral_position(uint32_t score) {
-    // - Find largest n where T(n) <= score
-    for (size_t i = 0; i < TETRAHEDRAL.size(); i++) {
-      if (TETRAHEDRAL[i] > score) {
-        return i; // - Return index where score exceeded
-      }
-    }
-    return TETRAHEDRAL.size() - 1; // - Return last position for large scores
+  static constexpr uint32_t calculate_tetrahedral_position(uint32_t score) {
+    // - Largest n where T(n) <= score, capped at the last position
+    return figurate::level(TETRAHEDRAL, score);
   }//END calculate_tetrahedral_position()
+
+  // === Action State === //
+  // --- Loaded at most once per action, flushed by the destructor --- //
+
+  cached_singleton<counted_t<config_table>, config> _config;
+  cached_table<counted_t<statshards_table>, stat_shard> _shards;
+  versioned_table<counted_t<adopters_table>, counted_t<adopters2_table>, adopter, adopter_codec> _adopters; // - Both layouts until migrated
+  counted_t<credits_table>                          _credits; // - Queue rows are written through so queue checks see them
+  std::optional<bool>                    _queue_empty; // - Whether _credits is empty, looked up once
+  change_log                             _changes; // - Adopter and config changes, appended at write-back
 };
\ No newline at end of file
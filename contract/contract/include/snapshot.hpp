@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// === Snapshot Records === //
+// --- Fixed-layout little-endian rows returned by the export actions and read by native/tools --- //
+
+namespace snapshot {
+
+  // - Bumped whenever a record layout changes
+  constexpr uint32_t VERSION = 1;
+
+  // - One adopter: account, invitedby, score, flags
+  constexpr uint32_t ADOPTER_RECORD_SIZE = 24;
+
+  // - One stake: staker, symbol (with precision), amount, last_claim, reserved
+  constexpr uint32_t STAKE_RECORD_SIZE = 32;
+
+  // - Largest page an export action returns
+  constexpr uint32_t MAX_PAGE_ROWS = 1000;
+
+  enum adopter_flag : uint32_t {
+    CLAIMED = 1u << 0, // - Reward already claimed
+    COMPACT = 1u << 1, // - Stored in the compact layout
+    PRUNED  = 1u << 2  // - Tombstone left by prune, upline path dropped
+  };
+
+  struct adopter_record {
+    uint64_t account = 0;
+    uint64_t inviter = 0;
+    uint32_t score = 0;
+    uint32_t flags = 0;
+  };
+
+  struct stake_record {
+    uint64_t staker = 0;
+    uint64_t symbol = 0;
+    int64_t  amount = 0;
+    uint32_t last_claim = 0;
+  };
+
+  // - Appends value as `bytes` little-endian bytes
+  inline void put(std::vector<char>& out, uint64_t value, uint32_t bytes) {
+    for (uint32_t i = 0; i < bytes; i++) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+
+  // - Reads `bytes` little-endian bytes
+  inline uint64_t get(const char* in, uint32_t bytes) {
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < bytes; i++) value |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+    return value;
+  }
+
+  inline void append(std::vector<char>& out, const adopter_record& row) {
+    put(out, row.account, 8);
+    put(out, row.inviter, 8);
+    put(out, row.score, 4);
+    put(out, row.flags, 4);
+  }
+
+  inline void append(std::vector<char>& out, const stake_record& row) {
+    put(out, row.staker, 8);
+    put(out, row.symbol, 8);
+    put(out, static_cast<uint64_t>(row.amount), 8);
+    put(out, row.last_claim, 4);
+    put(out, 0, 4); // - Reserved, zero
+  }
+
+  inline adopter_record read_adopter(const char* in) {
+    return {get(in, 8), get(in + 8, 8), static_cast<uint32_t>(get(in + 16, 4)), static_cast<uint32_t>(get(in + 20, 4))};
+  }
+
+  inline stake_record read_stake(const char* in) {
+    return {get(in, 8), get(in + 8, 8), static_cast<int64_t>(get(in + 16, 8)), static_cast<uint32_t>(get(in + 24, 4))};
+  }
+
+}
@@ -3,18 +3,49 @@
 #include <eosio/eosio.hpp>
 #include <eosio/asset.hpp>
 #include <eosio/singleton.hpp>
+#include <eosio/binary_extension.hpp>
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <string_view>
 #include <vector>
+#include "action_state.hpp"
+#include "instrumentation.hpp"
+#include "figurate.hpp"
+#include "fixed_point.hpp"
+#include "snapshot.hpp"
+#include "changelog.hpp"
 
 
 using namespace std;
 using namespace eosio;
 
-const std::vector<uint64_t> TETRAHEDRAL = {1, 4, 10, 20, 35, 56, 84, 120, 165, 220, 286, 364, 455, 560, 680, 816, 969, 1140, 1330, 1540, 1771, 2024, 2300, 2600, 2925, 3276, 3654, 4060, 4505, 4990, 5516, 6084, 6725, 7440, 8230, 9096, 99999999999};
-const std::vector<uint64_t> TRIANGULAR = {1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 66, 78, 91, 105, 120, 136, 153, 171, 190, 210, 231, 253, 276, 300, 325, 351, 378, 406 };
+// Stake levels: level n is reached at TETRAHEDRAL[n-1] tokens, and pays a TRIANGULAR[n] bonus
+constexpr auto TETRAHEDRAL = figurate::tetrahedral_series<36>();
+constexpr auto TRIANGULAR = figurate::triangular_series<TETRAHEDRAL.size() + 1>();
+static_assert(TRIANGULAR.size() > TETRAHEDRAL.size(), "Every stake level needs a bonus");
+
+// Start of the relative timestamps in compact stake rows (2024-01-01 00:00:00 UTC)
+constexpr uint32_t CONTRACT_EPOCH = 1704067200;
+
+// Minimum seconds between claims of a stake
+constexpr uint32_t MIN_CLAIM_INTERVAL = 200; // FLAG CHANGE THIS BACK TO 12 HOURS (43200)
+
+// Memo written on reward transfers, set per staked token
+enum memo_mode : uint8_t {
+    MEMO_FULL = 0,    // Emoji breakdown in the memo (default); stakes sharing a transfer get a logclaim receipt
+    MEMO_COMPACT = 1, // Short fixed memo, breakdown sent in a logclaim receipt
+    MEMO_EMPTY = 2    // Empty memo, breakdown sent in a logclaim receipt
+};
 
 CONTRACT stakepurple : public contract {
 public:
-    using contract::contract;
+    stakepurple(name receiver, name code, datastream<const char*> ds);
+
+    /**
+     * @brief Writes back every config and stake row the action changed, once each.
+     */
+    ~stakepurple();
 
     // === Admin Actions === //
 
@@ -38,6 +69,41 @@ public:
      */
     ACTION setparams(const name& user, const symbol& token_symbol, const name& token_contract, const symbol& reward_token_symbol, const name& reward_token_contract, const uint32_t& unstake_period, const uint32_t& reward_rate);
 
+    // --- Set reward memo mode --- //
+    /**
+     * @title Set Memo Mode
+     * @abi action setmemo
+     * @details Chooses the memo written on reward transfers for a staked token.
+     *
+     * **Parameters:**
+     * - `token_symbol`: The staked token symbol.
+     * - `memo_mode`: 0 = full breakdown, 1 = compact memo, 2 = empty memo. Compact and empty modes publish the breakdown through `logclaim`.
+     */
+    ACTION setmemo(const symbol& token_symbol, const uint8_t& memo_mode);
+
+    // --- Set change log retention --- //
+    /**
+     * @title Set Log
+     * @abi action setlog
+     * @details Sets how many change log entries are kept. Entries past it are trimmed now, up to changelog::TRIM_PER_SET, then as new ones are appended.
+     *
+     * **Parameters:**
+     * - `retention`: Entries kept; 0 turns the log off.
+     */
+    ACTION setlog(const uint32_t& retention);
+
+    // --- Read the change log --- //
+    /**
+     * @title Changes
+     * @abi action changes
+     * @details Read-only page of change log entries after `since_seq`: stakes, reward ledger rows and token configs that changed.
+     *
+     * **Parameters:**
+     * - `since_seq`: Last sequence already seen (0 reads from the oldest kept).
+     * - `max`: Entries returned, at most changelog::MAX_PAGE.
+     */
+    [[eosio::action, eosio::read_only]] change_page changes(const uint64_t& since_seq, const uint32_t& max);
+
     // === User Actions === //
 
     // --- Unstake tokens --- //
@@ -46,6 +112,153 @@ public:
     // --- Claim rewards --- //
     ACTION claim(const name& user);
 
+    // --- Withdraw credited rewards --- //
+    /**
+     * @title Withdraw
+     * @abi action withdraw
+     * @details Pays out the rewards credited by top-ups and unstakes, one transfer per reward token.
+     * claim pays them out as well, folded into its own transfers.
+     *
+     * **Parameters:**
+     * - `user`: The account to pay.
+     */
+    ACTION withdraw(const name& user);
+
+    // --- Claim for many stakers --- //
+    /**
+     * @title Claim Batch
+     * @abi action claimbatch
+     * @details Claims for up to `max_users` registered stakers, starting at `cursor`.
+     * Stakers that cannot claim yet (paused token or too soon) are skipped.
+     *
+     * **Parameters:**
+     * - `cursor`: First staker to visit (empty name starts from the beginning).
+     * - `max_users`: Stakers visited in this transaction.
+     *
+     * **Returns:** the cursor for the next call, or an empty name once every staker was visited.
+     */
+    [[eosio::action]] name claimbatch(const name& cursor, const uint32_t& max_users);
+
+    // --- Register existing stakers --- //
+    /**
+     * @title Add Stakers
+     * @abi action addstakers
+     * @details Adds accounts that staked before the registry existed. Accounts without stakes, or already registered, are skipped.
+     *
+     * **Parameters:**
+     * - `users`: Accounts to register.
+     */
+    ACTION addstakers(const std::vector<name>& users);
+
+    // --- List tokens configured before the allowlist --- //
+    /**
+     * @title List Tokens
+     * @abi action listtokens
+     * @details Adds every configured token to the allowlist under its token contract. Run it once after the upgrade:
+     * on_transfer only stakes listed tokens, and tokens configured before the allowlist are not listed until then.
+     */
+    ACTION listtokens();
+
+    // --- Move stakes to the compact layout --- //
+    /**
+     * @title Migrate
+     * @abi action migrate
+     * @details Moves the stakes of registered stakers to the compact layout, resuming where the last call stopped.
+     * Stakers are taken whole, so a chunk can pass `max_rows` by the stakes of its last staker.
+     *
+     * **Parameters:**
+     * - `max_rows`: Stakes visited in this transaction.
+     *
+     * **Returns:** the number of stakes moved.
+     */
+    [[eosio::action]] uint32_t migrate(const uint32_t& max_rows);
+
+    // --- Count stakes from before the token totals --- //
+    /**
+     * @title Count Stakes
+     * @abi action countstakes
+     * @details Adds the stakes of registered stakers to the token totals, resuming where the last call stopped.
+     * Totals are kept for stakers behind the cursor from then on, so they stay exact while counting spans several transactions.
+     * Run it once after the upgrade (it completes at once on a contract without stakers); add earlier stakers with addstakers first.
+     *
+     * **Parameters:**
+     * - `max_rows`: Stakes visited in this transaction.
+     *
+     * **Returns:** the number of stakes counted.
+     */
+    [[eosio::action]] uint32_t countstakes(const uint32_t& max_rows);
+
+    // --- Read token totals --- //
+    /**
+     * @brief Totals of one staked token.
+     */
+    struct token_totals {
+        asset total_staked;  // Sum of every stake
+        uint64_t stakers;    // Accounts holding a stake
+        name reward_token_contract;
+        asset rewards_paid;  // Rewards settled by claims, top-ups and unstakes since the upgrade, transferred or credited
+    };
+
+    /**
+     * @brief Totals of every configured token, by symbol code.
+     */
+    struct totals_page {
+        std::vector<token_totals> tokens;
+        bool complete = false; // countstakes finished; until then stakes and stakers cover only the stakers counted so far
+    };
+
+    /**
+     * @title Token Stats
+     * @abi action tokenstats
+     * @details Read-only totals of every configured token, kept by the actions that change stakes, so a dashboard reads them without scanning stakers.
+     *
+     * **Returns:** one entry per token, and whether the totals include every staker.
+     */
+    [[eosio::action, eosio::read_only]] totals_page tokenstats();
+
+    // --- Read a user's stakes --- //
+    /**
+     * @brief One stake as the legacy stakes table shows it.
+     */
+    struct user_stake {
+        asset staked_amount;
+        time_point_sec last_claim;
+    };
+
+    /**
+     * @title Get Stakes
+     * @abi action getstakes
+     * @details Read-only stakes of one account from both layouts, so clients need not decode the compact one.
+     *
+     * **Parameters:**
+     * - `user`: The staker.
+     *
+     * **Returns:** the user's stakes by symbol code (empty without stakes).
+     */
+    [[eosio::action, eosio::read_only]] std::vector<user_stake> getstakes(const name& user);
+
+    // --- Export stakes --- //
+    /**
+     * @brief One page of the stake export: rows holds snapshot::stake_record entries, by staker then symbol code.
+     */
+    struct stake_page {
+        std::vector<char> rows;
+        uint128_t cursor = 0; // Opaque, passed back to resume after this page
+        bool more = false;    // Rows remain after this page
+    };
+
+    /**
+     * @title Export Stakes
+     * @abi action exportstakes
+     * @details Read-only binary export of the stakes of registered stakers, in both layouts, for off-chain indexers.
+     * Stakers from before the registry are exported once added with addstakers.
+     *
+     * **Parameters:**
+     * - `cursor`: `cursor` of the previous page (0 starts from the beginning).
+     * - `limit`: Stakes returned, at most snapshot::MAX_PAGE_ROWS.
+     */
+    [[eosio::action, eosio::read_only]] stake_page exportstakes(const uint128_t& cursor, const uint32_t& limit);
+
     // === Notify Handlers === //
 
     // --- Handle incoming token transfers to automatically stake tokens --- //
@@ -55,7 +268,68 @@ public:
     // === Emergency Pause === //
     ACTION pause(bool should_pause, const name token_contract = name(), const symbol token_symbol = symbol());
 
-private:
+    // === Claim Receipts === //
+
+    /**
+     * @brief Reward breakdown for one staked token, as published by logclaim.
+     */
+    struct claim_receipt {
+        symbol staked_symbol;     // Staked token
+        asset reward;             // Reward paid for this stake (including the bonus)
+        uint32_t elapsed_seconds; // Time since the last claim
+        uint32_t days_passed;     // Whole days rewarded
+        uint64_t staked_amount;   // Staked whole tokens
+        uint32_t reward_rate;     // Rate applied (x100, level included)
+        uint32_t bonus;           // Level bonus
+        uint64_t next_level;      // Tokens still needed for the next level (0 at the top)
+    };
+
+    /**
+     * @title Log Claim
+     * @abi action logclaim
+     * @details Inline-only receipt, for indexers, of the stakes whose breakdown is not in a transfer memo:
+     * tokens using a compact or empty memo, and full-memo stakes paid in one transfer with other stakes.
+     *
+     * @param user - The account that was paid
+     * @param receipts - One entry per stake paid
+     *
+     * @pre Requires contract authority
+     */
+    ACTION logclaim(const name& user, const std::vector<claim_receipt>& receipts);
+
+    // --- Read pending rewards --- //
+    /**
+     * @title Get Rewards
+     * @abi action getrewards
+     * @details Read-only breakdown of what a claim would pay now for each stake, from both layouts: the reward with
+     * its level bonus, the rate and the tokens left to the next level. Paused time is not counted, and credited
+     * rewards (see withdraw) are not included.
+     *
+     * **Parameters:**
+     * - `user`: The staker.
+     *
+     * **Returns:** one receipt per stake, by symbol code (empty without stakes).
+     */
+    [[eosio::action, eosio::read_only]] std::vector<claim_receipt> getrewards(const name& user);
+
+    // --- Reward Index --- //
+    /**
+     * @brief Running totals of one token's emission, advanced only when its rate or pause state changes.
+     */
+    struct reward_index {
+        uint64_t rate_seconds = 0;   // Sum of reward_rate x seconds while unpaused
+        uint64_t active_seconds = 0; // Seconds while unpaused
+        time_point_sec updated;      // End of the last closed epoch (0: not started, as on configs from before the index)
+    };
+
+    /**
+     * @brief Index totals a stake was last settled at.
+     */
+    struct stake_checkpoint {
+        uint64_t rate_seconds = 0;
+        uint64_t active_seconds = 0;
+    };
+
     // --- Staking Parameters --- //
     TABLE config {
         name creator;
@@ -66,6 +340,8 @@ private:
         uint32_t unstake_period;
         uint32_t reward_rate; // Reward rate percentage
         bool is_paused = false;
+        binary_extension<uint8_t> memo_mode; // memo_mode for reward transfers (MEMO_FULL when unset)
+        binary_extension<reward_index> index; // Emission totals (set on first use)
 
         uint64_t primary_key() const { return token_symbol.code().raw(); }
         uint64_t by_reward_symbol() const { return reward_token_symbol.code().raw(); }
@@ -75,6 +351,7 @@ private:
     TABLE stake_s {
         asset staked_amount;
         time_point_sec last_claim;
+        binary_extension<stake_checkpoint> checkpoint; // Unset on stakes from before the index, set before they are written again
 
         uint64_t primary_key() const { return staked_amount.symbol.code().raw(); }
     };
@@ -84,13 +361,287 @@ private:
     > config_t;
     typedef multi_index<"stakes"_n, stake_s> stake_t;
 
+private:
+
+    // --- Stakeable Token Contracts --- //
+    /**
+     * @brief Symbols staked through each token contract, kept by setparams. on_transfer stakes these after
+     * one small lookup and rejects anything else; tokens configured before this table existed are added by listtokens.
+     */
+    TABLE allowed_contract {
+        name contract;                    // First receiver of the transfer
+        std::vector<symbol_code> symbols; // Configured stake symbols it issues
+
+        uint64_t primary_key() const { return contract.value; }
+    };
+
+    typedef multi_index<"allowlist"_n, allowed_contract> allowlist_t;
+
+    // --- Token Totals --- //
+    /**
+     * @brief Aggregates of one token, updated in the same action as the stakes they count. Kept out of config,
+     * so claims, top-ups and unstakes do not rewrite the token's parameters; stats writes are not change-logged.
+     */
+    TABLE token_stats {
+        symbol_code token_code;   // Staked token
+        int64_t total_staked = 0; // In the staked token's precision
+        uint64_t stakers = 0;     // Stakes of the token, one per account
+        int64_t rewards_paid = 0; // In the reward token's precision
+
+        uint64_t primary_key() const { return token_code.raw(); }
+    };
+
+    typedef multi_index<"tokenstats"_n, token_stats> tokenstats_t;
+
+    // --- Reward Ledger --- //
+    /**
+     * @brief Rewards settled by top-ups and unstakes, owed to the scope's user until withdraw or claim pays them.
+     * One row per reward token, found by (contract, symbol) so tokens sharing a symbol code are owed side by side;
+     * the contract pays for the rows.
+     */
+    TABLE reward_balance {
+        uint64_t id;         // Row id, from available_primary_key
+        name token_contract; // Contract issuing the reward token
+        asset balance;       // Owed amount
+
+        uint64_t primary_key() const { return id; }
+        uint128_t by_token() const { return token_key(token_contract, balance.symbol); }
+
+        // Contract in the high half, symbol in the low half
+        static uint128_t token_key(const name& token_contract, const symbol& sym) {
+            return (static_cast<uint128_t>(token_contract.value) << 64) | sym.raw();
+        }
+    };
+
+    typedef multi_index<"rewards"_n, reward_balance,
+        indexed_by<"bytoken"_n, const_mem_fun<reward_balance, uint128_t, &reward_balance::by_token>>
+    > rewards_t;
+
+    // --- Compact User Stakes --- //
+    /**
+     * @brief stake_s in 13 bytes before the checkpoint instead of 20: the symbol is a one-byte slot and last_claim counts from CONTRACT_EPOCH.
+     * Stakes get their checkpoint before they are packed, so it is a plain field here.
+     */
+    TABLE stake_v2 {
+        uint8_t slot;        // Staked symbol, interned in symslots
+        int64_t amount;      // Staked amount in the symbol's precision
+        uint32_t last_claim; // Seconds since CONTRACT_EPOCH
+        stake_checkpoint checkpoint; // Index totals the stake was last settled at
+
+        uint64_t primary_key() const { return slot; }
+    };
+
+    typedef multi_index<"stakes2"_n, stake_v2> stake_v2_t;
+
+    // --- Symbol Slots --- //
+    TABLE symbol_slot {
+        uint64_t slot; // Index stored on compact stakes
+        symbol sym;    // Staked token symbol
+
+        uint64_t primary_key() const { return slot; }
+    };
+
+    typedef multi_index<"symslots"_n, symbol_slot> symslots_t;
+
+    // --- Migration Progress --- //
+    TABLE migration_state {
+        name cursor;       // First staker the next chunk visits
+        bool done = false; // Every registered staker was visited
+    };
+
+    typedef singleton<"migration"_n, migration_state> migration_t;
+
+    // --- Stake Count Progress --- //
+    /**
+     * @brief How far countstakes got. Stakers before the cursor are in the totals; the rest are added when it reaches them.
+     */
+    TABLE count_state {
+        name cursor;       // First staker the next chunk counts
+        bool done = false; // Every registered staker was counted
+    };
+
+    typedef singleton<"stakecount"_n, count_state> count_t;
+
+    /**
+     * @brief Staked symbols by slot, loaded once per action. New slots are written through so flushes can use them.
+     */
+    class symbol_slots {
+    public:
+        symbol_slots(name code) : _table(code, code.value), _code(code) {}
+
+        std::optional<uint64_t> find(const symbol_code& code);
+        uint64_t intern(const symbol& sym);
+        const symbol& get(uint64_t slot);
+
+    private:
+        void load();
+
+        counted_t<symslots_t> _table;
+        name _code;
+        std::vector<symbol> _symbols; // Indexed by slot
+        bool _loaded = false;
+    };
+
+    /**
+     * @brief Converts stakes between the stake_s and stake_v2 layouts for versioned_table.
+     */
+    struct stake_codec {
+        symbol_slots* slots;
+
+        std::optional<uint64_t> new_key(uint64_t pk) const { return slots->find(symbol_code(pk)); }
+        uint64_t old_key(const stake_v2& row) const { return slots->get(row.slot).code().raw(); }
+        stake_v2 pack(const stake_s& row) const;
+        stake_s unpack(const stake_v2& row) const;
+    };
+
+    typedef versioned_table<counted_t<stake_t>, counted_t<stake_v2_t>, stake_s, stake_codec> stakes_table;
+
+    // --- Staker Registry --- //
+    TABLE staker {
+        name account; // Has at least one stake
+
+        uint64_t primary_key() const { return account.value; }
+    };
+
+    typedef multi_index<"stakers"_n, staker> stakers_t;
+
     // === Utility Functions === //
     /**
      * @brief Processes the claim for a user.
      * 
      * @param user The account claiming rewards.
      * @param reset_unstake_period Whether to reset the unstake period after claiming.
+     * @param pay_out True to transfer the rewards, with any credited ones; false to credit them to the ledger.
+     */
+    void process_claim(const name& user, bool reset_unstake_period = true, bool pay_out = true);
+
+    /**
+     * @brief Adds a reward to the user's ledger row for its token.
+     *
+     * @param user The account owed the reward.
+     * @param token_contract Contract issuing the reward token.
+     * @param reward Amount owed.
+     */
+    void credit_reward(const name& user, const name& token_contract, const asset& reward);
+
+    /**
+     * @brief Transfers and clears every ledger row of the user.
+     *
+     * @param user The account to pay.
+     * @return Number of transfers sent.
+     */
+    uint32_t pay_rewards(const name& user);
+
+    /**
+     * @brief Whether process_claim would pay the user now: they have stakes, none is paused, and the claim interval has passed.
+     *
+     * @param user The staker to check.
+     */
+    bool can_claim(const name& user);
+
+    /**
+     * @brief Current index of a token: the stored totals plus the open epoch. Stores a starting index the first time.
+     *
+     * @param token_code Staked token symbol code.
+     */
+    reward_index index_of(const symbol_code& token_code);
+
+    /**
+     * @brief Current index of a token without storing anything; a token whose index has not started starts now.
+     *
+     * @param token_config Config of the token.
+     */
+    reward_index current_index(const config& token_config) const;
+
+    /**
+     * @brief What a claim pays for one stake at `index`, with the breakdown logclaim publishes.
+     *
+     * @param row The stake.
+     * @param token_config Config of the staked token.
+     * @param index Current index of the token.
+     */
+    claim_receipt receipt_of(const stake_s& row, const config& token_config, const reward_index& index) const;
+
+    /**
+     * @brief Checkpoint a stake is settled from: its own, or for a stake from before the index, one that owes
+     * its whole days since last_claim at the current rate, as it would have been paid by time. That checkpoint
+     * sits below the index and may wrap under zero; settling subtracts it modulo 2^64 all the same.
+     *
+     * @param row The stake.
+     * @param token_config Config of the staked token.
+     * @param index Current index of the token.
+     */
+    stake_checkpoint checkpoint_of(const stake_s& row, const config& token_config, const reward_index& index) const;
+
+    /**
+     * @brief Writes the current index into config, so a rate or pause change only affects time after now.
+     *
+     * @param token_code Staked token symbol code.
+     */
+    void close_epoch(const symbol_code& token_code);
+
+    /**
+     * @brief Lists token_code under token_contract in the allowlist, or removes it.
+     *
+     * @param token_contract Contract issuing the staked token.
+     * @param token_code Staked token symbol code.
+     * @param allowed True to add, false to remove.
+     */
+    void set_allowed(const name& token_contract, const symbol_code& token_code, bool allowed);
+
+    /**
+     * @brief Adds the user to the staker registry if missing. A staker added behind the countstakes cursor
+     * has its stakes added to the token totals, since countstakes will not reach it.
+     *
+     * @param user The staker to register.
+     */
+    void register_staker(const name& user);
+
+    /**
+     * @brief Adds every stake of the user to the token totals.
+     *
+     * @param user The staker.
+     * @return Number of stakes counted.
+     */
+    uint32_t count_staker(const name& user);
+
+    /**
+     * @brief Whether stake changes of the user go into the token totals now: countstakes is done or past the user.
+     *
+     * @param user The staker.
+     */
+    bool is_counted(const name& user);
+
+    /**
+     * @brief Adds a stake change to the token totals, if countstakes already counted the user.
+     *
+     * @param user The staker.
+     * @param delta Staked amount added (negative when unstaked).
+     * @param stakers_delta 1 for a new stake, -1 for an erased one, 0 otherwise.
+     */
+    void count_stake(const name& user, const asset& delta, int64_t stakers_delta);
+
+    /**
+     * @brief Writable totals of a token (zero on first use), marked for write-back.
+     *
+     * @param token_code Staked token symbol code.
+     */
+    token_stats& stats_of(const symbol_code& token_code);
+
+    /**
+     * @brief Cached stakes of one user, created on first use.
+     *
+     * @param user The scope of the stakes table.
      */
-    void process_claim(const name& user, bool reset_unstake_period = true);
+    stakes_table& stakes_of(const name& user);
+
+    // === Action State === //
+    cached_table<counted_t<config_t>, config> _configs;    // Token configs, read and written once per action
+    cached_table<counted_t<tokenstats_t>, token_stats> _stats; // Token totals, written once per action
+    symbol_slots _slots;                                    // Symbols of compact stakes
+    std::map<name, stakes_table> _stakes;                   // Stakes per user scope, in both layouts until migrated
+    cached_table<counted_t<stakers_t>, staker> _stakers;   // Staker registry
+    change_log _changes;                                    // Stake, ledger and config changes, appended at write-back
+    std::optional<count_state> _count;                      // countstakes progress, read on the first stake change
 
 };
\ No newline at end of file
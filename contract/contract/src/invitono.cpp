@@ -1,5 +1,28 @@
 #include "invitono.hpp"
 
+// === Action State === //
+// --- Table handles are built once; rows and singletons load on first use --- //
+
+invitono::invitono(name receiver, name code, datastream<const char*> ds)
+  : contract(receiver, code, ds),
+    _config(receiver, receiver.value),
+    _shards(receiver, receiver.value),
+    _adopters(receiver, receiver.value),
+    _credits(receiver, receiver.value),
+    _changes(receiver) {}
+
+invitono::~invitono() {
+  // - Each changed row is written exactly once, after all the action's updates,
+  //   and logged once for indexers
+  _config.flush([&] { _changes.append(changelog::CONFIG, name{}); });
+  _shards.flush();
+  _adopters.flush([&](uint64_t pk) { _changes.append(changelog::ADOPTER, name(pk)); });
+  _changes.flush();
+
+  // - Counts of the whole action, write-back included (instrumented builds only)
+  instrumentation::report();
+}
+
 // === Register User === //
 // --- Registers a user with a referral code and applies multi-level scoring --- //
 
@@ -7,87 +30,306 @@ void invitono::registeruser(name user, name inviter) {
   // - Authorization check
   check(has_auth(user) || has_auth(get_self()), "Only the user can invite");
 
+  add_adopter(user, inviter, user);
+  count_registrations(user, 1);
+}//END registeruser()
+
+// === Register Batch === //
+// --- Registers many users at once; shared ancestors are written back a single time --- //
+
+void invitono::registerbatch(std::vector<registration> registrations) {
+  // - Authorization check
+  const auto& cfg = _config.get();
+  check(has_auth(get_self()) || (cfg.admin != name{} && has_auth(cfg.admin)), "Only the contract or admin can register in batch");
+  check(!registrations.empty(), "Batch is empty");
+
+  // - Same path as registeruser; config and every touched ancestor stay
+  //   in the action cache, so each row is written once when the action ends
+  for (const auto& reg : registrations) {
+    // - Contract pays, the batch users did not sign
+    add_adopter(reg.user, reg.inviter, get_self());
+  }
+
+  // - The whole batch is counted in one shard
+  count_registrations(registrations.back().user, registrations.size());
+}//END registerbatch()
+
+// === Add Adopter === //
+// --- Validates one registration, creates the row and credits the upline --- //
+
+void invitono::add_adopter(name user, name inviter, name payer) {
   // - Account validation
   check(is_account(inviter), "Inviter account does not exist");
   check(user != inviter, "Cannot invite yourself");
 
   // - Registration status check
-  adopters_table adopters(get_self(), get_self().value);
-  auto existing = adopters.find(user.value);
-  check(existing == adopters.end(), "User already registered");
+  check(_adopters.find(user.value) == nullptr, "User already registered");
 
   // - Inviter validation
-  auto inviter_itr = adopters.find(inviter.value);
-  check(inviter_itr != adopters.end(), "Inviter must be registered first");
+  const adopter* inviter_row = _adopters.find(inviter.value);
+  check(inviter_row != nullptr, "Inviter must be registered first");
 
   // - Configuration check
-  config_table conf(get_self(), get_self().value);
-  auto cfg = conf.get_or_default();
+  const auto& cfg = _config.get();
   check(cfg.enabled, "Registration is currently disabled");
 
   // - Account age verification
-  time_point_sec now = time_point_sec(current_time_point());
-  time_point_sec creation_date = get_account_creation_time(user);
-  check((now.sec_since_epoch() - creation_date.sec_since_epoch()) >= cfg.min_account_age_days * 86400,
-        "Account must be at least " + std::to_string(cfg.min_account_age_days) + " days old to register");
+  check_account_age(user, cfg);
+
+  // - Create new user record with its upline taken from the inviter's path
+  uint32_t now = current_time_point().sec_since_epoch();
+  adopter row;
+  row.account = user;
+  row.invitedby = inviter;
+  row.lastupdated = now;
+  row.score = 1;
+  row.claimed = false;
+  row.upline.emplace(upline_path{child_upline(*inviter_row, cfg.max_referral_depth), true});
+
+  // - Counted into the upline by the credit below
+  referral_counts counts;
+  counts.counted = true;
+  row.referrals.emplace(counts);
+  _adopters.emplace(payer, std::move(row));
+
+  // - Update referral scores and counts
+  credit_upline(inviter, now);
+}//END add_adopter()
+
+// === Walk Upline === //
+// --- Visits ancestors first_level..max_depth, stepping through known keys --- //
+
+template <typename Visitor>
+void invitono::walk_upline(name direct_inviter, uint16_t max_depth, uint16_t first_level, Visitor&& visit) {
+    const adopter* row = _adopters.find(direct_inviter.value);
+    if (row == nullptr) return;
+
+    // - Ancestors above invitedby are known up front from the inviter's stored path
+    const std::vector<name> path = row->upline.value_or().ancestors;
+    uint16_t level = 1;
+
+    // - Resuming: jump straight to the first owed level when the path reaches it
+    if (first_level > 1) {
+        uint16_t reach = std::min<size_t>(first_level, path.size() + 2);
+        name target = reach == 2 ? row->invitedby : path[reach - 3];
+        if (target == name{}) return;
+
+        row = _adopters.find(target.value);
+        if (row == nullptr) return;
+        level = reach;
+    }
 
-  // - Create new user record
-  adopters.emplace(user, [&](auto& row) {
-    row.account = user;
-    row.invitedby = inviter;
-    row.lastupdated = current_time_point().sec_since_epoch();
-    row.score = 1;
-    row.claimed = false;
-  });
-
-  // - Update global statistics
-  stats_table stats(get_self(), get_self().value);
-  auto current = stats.get_or_default();
-  current.total_users += 1;
-  current.total_referrals += 1;
-  current.last_registered = user;
-  stats.set(current, get_self());
-
-  // - Update referral scores
-  update_scores(inviter);
-}//END registeruser()
+    for (; level <= max_depth; level++) {
+        if (level >= first_level && !visit(*row, level)) return;
+
+        // - Level 1 steps to invitedby, deeper levels read the path and fall back to
+        //   invitedby once it runs out (legacy rows, or a path cut at a smaller depth)
+        name next = row->invitedby;
+        if (level >= 2 && size_t(level - 2) < path.size()) next = path[level - 2];
+        if (next == name{}) return;
+
+        row = _adopters.find(next.value);
+        if (row == nullptr) return;
+    }
+}//END walk_upline()
 
 // === Update Scores === //
-// --- Applies +1 score to inviter and their upline if cooldown has passed --- //
-
-void invitono::update_scores(name direct_inviter) {
-    // - Initialize tables
-    adopters_table adopters(get_self(), get_self().value);
-    config_table conf(get_self(), get_self().value);
-    auto cfg = conf.get_or_default();
-
-    // - Build upline chain
-    std::vector<std::pair<name, uint16_t>> upline;
-    uint16_t current_level = 1;
-
-    // - Traverse referral chain up to max depth
-    auto current_itr = adopters.find(direct_inviter.value);
-    while (current_itr != adopters.end() && current_level <= cfg.max_referral_depth) {
-        upline.push_back({current_itr->account, current_level});
-        
-        if (current_itr->invitedby == name{}) break;
-        current_itr = adopters.find(current_itr->invitedby.value);
-        current_level++;
+// --- Applies +1 score to inviter and their upline if cooldown has passed, and counts the new adopter --- //
+
+bool invitono::update_scores(name direct_inviter, uint32_t at, uint16_t first_level, uint16_t last_level) {
+    const auto& cfg = _config.get();
+
+    // - Credit each level whose cooldown has passed, stopping at the first level past the budget
+    bool owed = false;
+    walk_upline(direct_inviter, cfg.max_referral_depth, first_level, [&](const adopter& row, uint16_t level) {
+        if (level > last_level) {
+            owed = true;
+            return false;
+        }
+        // - Every level counts the new adopter, cooldown or not
+        adopter credited = row;
+        count_downline(credited, level);
+        if ((at - credited.lastupdated) >= cfg.invite_rate_seconds) {
+            credited.score += 1;
+            credited.lastupdated = at;
+        }
+        _adopters.modify(row.account.value, growth_payer(row, credited)) = std::move(credited);
+        return true;
+    });
+    return owed;
+}//END update_scores()
+
+// === Credit Upline === //
+// --- Inline walk up to the level budget, the rest (or all of it when lazy) queued --- //
+
+void invitono::credit_upline(name direct_inviter, uint32_t at) {
+    const auto& cfg = _config.get();
+
+    // - Credits must land in order, so anything queued forces this one into the queue too
+    if (!_queue_empty.has_value()) _queue_empty = _credits.begin() == _credits.end();
+    if (cfg.lazy_scores.value_or(false) || !*_queue_empty) {
+        queue_credit(direct_inviter, at, 1);
+        return;
+    }
+
+    // - Inline budget keeps registration cost flat however deep the tree is
+    uint16_t budget = cfg.inline_levels.value_or(0);
+    if (budget == 0 || budget >= cfg.max_referral_depth) {
+        update_scores(direct_inviter, at);
+        return;
     }
 
-    // - Update scores with level multipliers
-    for (const auto& [account, level] : upline) {
-        auto itr = adopters.find(account.value);
-        if (itr != adopters.end()) {
-            if ((current_time_point().sec_since_epoch() - itr->lastupdated) >= cfg.invite_rate_seconds) {
-                adopters.modify(itr, same_payer, [&](auto& row) {
-                    row.score += 1;
-                    row.lastupdated = current_time_point().sec_since_epoch();
-                });
-            }
+    if (update_scores(direct_inviter, at, 1, budget)) {
+        queue_credit(direct_inviter, at, budget + 1);
+    }
+}//END credit_upline()
+
+// === Queue Credit === //
+// --- Appends a credit (or its unfinished levels) for crank --- //
+
+void invitono::queue_credit(name direct_inviter, uint32_t at, uint16_t from_level) {
+    // - One row however deep the tree is; views replay the queue instead of reading an index
+    uint64_t id = _credits.available_primary_key();
+    _credits.emplace(get_self(), [&](auto& row) {
+        row.id = id;
+        row.inviter = direct_inviter;
+        row.created = at;
+        row.from_level = from_level;
+    });
+    _queue_empty = false;
+}//END queue_credit()
+
+// === Apply Credits === //
+// --- Applies queued credits oldest first, shared by crank and claimreward --- //
+
+uint32_t invitono::apply_credits(uint32_t max_items) {
+    uint32_t done = 0;
+    for (auto itr = _credits.begin(); itr != _credits.end() && done < max_items; done++) {
+        update_scores(itr->inviter, itr->created, itr->from_level);
+        itr = _credits.erase(itr);
+    }
+    _queue_empty.reset();
+    return done;
+}//END apply_credits()
+
+// === With Pending === //
+// --- Replays queued credits against one user without writing anything --- //
+
+bool invitono::with_pending(adopter& current) {
+    const auto& cfg = _config.get();
+    referral_counts counts = current.referrals.value_or();
+    bool counted = false;
+
+    // - Same rule and order crank applies, so the result matches the eager path; each credit
+    //   is a walk, so only the oldest PENDING_READ_LIMIT are read
+    auto credit = _credits.begin();
+    for (uint32_t read = 0; credit != _credits.end() && read < PENDING_READ_LIMIT; read++, credit++) {
+        uint16_t reached = 0;
+        walk_upline(credit->inviter, cfg.max_referral_depth, credit->from_level, [&](const adopter& row, uint16_t level) {
+            if (row.account == current.account) reached = level;
+            return reached == 0;
+        });
+        if (reached == 0) continue;
+
+        if (reached == 1) counts.direct++;
+        counts.downline++;
+        counted = true;
+        if ((credit->created - current.lastupdated) >= cfg.invite_rate_seconds) {
+            current.score += 1;
+            current.lastupdated = credit->created;
         }
     }
-}//END update_scores()
+    if (counted) current.referrals.emplace(counts);
+    return credit == _credits.end();
+}//END with_pending()
+
+// === Count Downline === //
+// --- One more adopter below ancestor; level 1 is a direct invite --- //
+
+void invitono::count_downline(adopter& ancestor, uint16_t level) {
+  referral_counts counts = ancestor.referrals.value_or();
+  if (level == 1) counts.direct++;
+  counts.downline++;
+  ancestor.referrals.emplace(counts);
+}//END count_downline()
+
+// === Growth Payer === //
+// --- Who pays for a write to another adopter's row --- //
+
+/*/
+A row keeps its payer unless the write makes it longer: growing a user-paid row
+needs that user's signature, so only then does the contract take the row over
+(the whole row, upline included). Counts are fixed-width, so that happens on the
+first write to a row from before the extensions (every write stores them all),
+or when a compact row's varuint score gets a byte longer (at 128, 16384, ...)
+/*/
+name invitono::growth_payer(const adopter& before, const adopter& after) const {
+  bool grows = !before.upline.has_value() || !before.referrals.has_value()
+    || varuint_size(after.score) > varuint_size(before.score);
+  return grows ? get_self() : same_payer;
+}//END growth_payer()
+
+// === Child Upline === //
+// --- Path stored on a new child: the inviter's inviter, then the inviter's own path --- //
+
+std::vector<name> invitono::child_upline(const adopter& inviter, uint16_t max_depth) {
+  std::vector<name> upline;
+
+  // - Registrations under the child credit the child, its inviter, then at most
+  //   max_depth - 2 further ancestors, which is all the path needs to hold
+  if (max_depth <= 2 || inviter.invitedby == name{}) return upline;
+  size_t limit = max_depth - 2;
+  upline.reserve(limit);
+  upline.push_back(inviter.invitedby);
+
+  if (has_path(inviter)) {
+    for (const auto& ancestor : inviter.upline->ancestors) {
+      if (upline.size() >= limit) break;
+      upline.push_back(ancestor);
+    }
+    return upline;
+  }
+
+  // - Legacy inviter without a stored path: chase pointers once here
+  name next = inviter.invitedby;
+  while (upline.size() < limit) {
+    const adopter* row = _adopters.find(next.value);
+    if (row == nullptr || row->invitedby == name{}) break;
+    next = row->invitedby;
+    upline.push_back(next);
+  }
+  return upline;
+}//END child_upline()
+
+// === Check Account Age === //
+// --- Rejects accounts younger than min_account_age_days --- //
+
+void invitono::check_account_age(name user, const config& cfg) {
+  time_point_sec now = time_point_sec(current_time_point());
+  time_point_sec creation_date = get_account_creation_time(user);
+  check((now.sec_since_epoch() - creation_date.sec_since_epoch()) >= cfg.min_account_age_days * 86400,
+        "Account must be at least " + std::to_string(cfg.min_account_age_days) + " days old to register");
+}//END check_account_age()
+
+// === Count Registrations === //
+// --- Adds registrations to one stats shard; the singleton is left untouched --- //
+
+void invitono::count_registrations(name user, uint64_t count) {
+  uint64_t shard = stats_shard_of(user);
+  uint32_t now = current_time_point().sec_since_epoch();
+
+  if (_shards.find(shard) == nullptr) {
+    stat_shard row;
+    row.id = shard;
+    _shards.emplace(get_self(), row);
+  }
+
+  auto& row = _shards.modify(shard);
+  row.total_users += count;
+  row.total_referrals += count;
+  row.last_registered = user;
+  row.last_registered_at = now;
+}//END count_registrations()
 
 // === Claim Reward === //
 // --- Mints tokens based on invite score (1 TOKEN per point) --- //
@@ -97,33 +339,34 @@ void invitono::claimreward(name user) {
   check(has_auth(user) || has_auth(get_self()), "Only the user or contract can claim rewards");
 
   // - Contract status check
-  config_table conf(get_self(), get_self().value);
-  auto cfg = conf.get_or_default();
+  const auto& cfg = _config.get();
   check(cfg.enabled, "Contract is currently disabled");
 
   // - User validation
-  adopters_table adopters(get_self(), get_self().value);
-  auto itr = adopters.find(user.value);
-  check(itr != adopters.end(), "User not found");
-  check(!itr->claimed, "Already claimed rewards");
-
-  // - Score validation
-  uint32_t score = itr->score;
+  const adopter* row = _adopters.find(user.value);
+  check(row != nullptr, "User not found");
+  check(!row->claimed, "Already claimed rewards");
+
+  // - Score validation, counting credits still queued for this user: a few are applied
+  //   here and the rest replayed, so the claim's cost stays bounded however long the queue is
+  apply_credits(CLAIM_CRANK_ITEMS);
+  adopter current = *_adopters.find(user.value);
+  check(with_pending(current), "Too many credits queued, run crank first");
+  uint32_t score = current.score;
   check(score > 0, "No rewards to claim");
 
-  // - Mark as claimed
-  adopters.modify(itr, same_payer, [&](auto& row) {
-    row.claimed = true;
-  });
+  // - Mark as claimed (the stored score is left for crank to bring up to date); the claim
+  //   may be signed by the contract alone, so a row that grows is taken over by it
+  const adopter& stored = *_adopters.find(user.value);
+  adopter marked = stored;
+  marked.claimed = true;
+  _adopters.modify(user.value, growth_payer(stored, marked)) = std::move(marked);
 
   // - Calculate reward position
   uint32_t position = calculate_tetrahedral_position(score);
-  
+
   // - Calculate reward amount
-  uint8_t precision = cfg.reward_symbol.precision();
-  int64_t amount = (static_cast<int64_t>(position) * static_cast<int64_t>(pow(10, precision)) * cfg.reward_rate) / 100;
-  check(position <= UINT32_MAX / static_cast<uint32_t>(pow(10, precision)) * 100 / cfg.reward_rate, "Position overflow");
-  asset reward = asset(amount, cfg.reward_symbol);
+  asset reward = reward_for(position, cfg);
 
   // - Transfer reward tokens
   action(
@@ -132,15 +375,28 @@ void invitono::claimreward(name user) {
     "transfer"_n,
     std::make_tuple(get_self(), user, reward, std::string("Invitono tetrahedral position reward"))
   ).send();
+  instrumentation::inline_sent();
 }//END claimreward()
 
+// === Reward For === //
+// --- Tokens paid for a tetrahedral position --- //
+
+asset invitono::reward_for(uint32_t position, const config& cfg) {
+  // - position x reward_rate / 100 tokens, rounded down to the reward symbol's smallest unit
+  std::optional<fixed_point::uint128> units = fixed_point::to_units(position, cfg.reward_symbol.precision());
+  std::optional<int64_t> amount = fixed_point::to_amount(
+    units.has_value() ? fixed_point::mul_div(*units, cfg.reward_rate, 100) : std::nullopt);
+  check(amount.has_value(), "Reward overflow");
+  return asset(*amount, cfg.reward_symbol);
+}//END reward_for()
+
 // === Set Config === //
 // --- Admin sets contract-wide configuration --- //
 
 void invitono::setconfig(
-    name admin, 
-    uint32_t min_age_days, 
-    uint32_t rate_seconds, 
+    name admin,
+    uint32_t min_age_days,
+    uint32_t rate_seconds,
     bool enabled,
     uint16_t max_depth,
     uint16_t multiplier,
@@ -148,9 +404,6 @@ void invitono::setconfig(
     symbol reward_symbol,
     uint32_t reward_rate
 ) {
-    // - Initialize config table
-    config_table conf(get_self(), get_self().value);
-
     // - Parameter validation
     check(max_depth > 0 && max_depth <= 100, "Invalid depth (1-100)");
     check(multiplier > 0 && multiplier <= 1000, "Invalid multiplier (1-1000)");
@@ -160,9 +413,9 @@ void invitono::setconfig(
     check(reward_rate > 0, "Reward rate must be positive");
 
     // - Handle first-time initialization
-    if (!conf.exists()) {
+    if (!_config.exists()) {
         require_auth(get_self());
-        conf.set(config{
+        _config.set(config{
             .min_account_age_days = min_age_days,
             .invite_rate_seconds = rate_seconds,
             .enabled = enabled,
@@ -172,12 +425,12 @@ void invitono::setconfig(
             .token_contract = token_contract,
             .reward_symbol = reward_symbol,
             .reward_rate = reward_rate
-        }, get_self());
+        });
         return;
     }
 
     // - Normal admin updates
-    auto current = conf.get();
+    const auto& current = _config.get();
     require_auth(current.admin);
 
     // - Additional validation
@@ -185,7 +438,7 @@ void invitono::setconfig(
     check(rate_seconds > 0, "Rate must be positive");
 
     // - Update configuration
-    conf.set(config{
+    _config.set(config{
         .min_account_age_days = min_age_days,
         .invite_rate_seconds = rate_seconds,
         .enabled = enabled,
@@ -194,8 +447,10 @@ void invitono::setconfig(
         .multiplier = multiplier,
         .token_contract = token_contract,
         .reward_symbol = reward_symbol,
-        .reward_rate = reward_rate
-    }, get_self());
+        .reward_rate = reward_rate,
+        .lazy_scores = current.lazy_scores,
+        .inline_levels = current.inline_levels
+    });
 }//END setconfig()
 
 // === Delete User === //
@@ -206,9 +461,417 @@ void invitono::deleteuser(name user) {
   require_auth(get_self());
 
   // - Remove user record
-  adopters_table adopters(get_self(), get_self().value);
-  auto itr = adopters.find(user.value);
-  if (itr != adopters.end()) {
-    adopters.erase(itr);
+  if (_adopters.find(user.value) != nullptr) {
+    _adopters.erase(user.value);
   }
-}//END deleteuser()
\ No newline at end of file
+}//END deleteuser()
+
+// === Backfill === //
+// --- Admin fills the upline path on rows registered before it was stored --- //
+
+void invitono::backfill(name from, uint32_t max_rows) {
+  // - Authorization check
+  const auto& cfg = _config.get();
+  check(has_auth(get_self()) || (cfg.admin != name{} && has_auth(cfg.admin)), "Only the contract or admin can backfill");
+  check(max_rows > 0, "max_rows must be positive");
+
+  // - Compact rows always carry a path, so only the old layout is walked
+  auto& adopters = _adopters.old_table();
+  auto itr = adopters.lower_bound(from.value);
+
+  // - Walk one chunk; rows that already carry a path still count toward max_rows
+  for (uint32_t processed = 0; itr != adopters.end() && processed < max_rows; processed++, itr++) {
+    const adopter& row = *_adopters.find(itr->account.value);
+    if (has_path(row)) continue;
+
+    // - Contract pays for the larger row, the original payer did not sign
+    std::vector<name> upline = backfill_upline(row);
+    _adopters.modify(row.account.value, get_self()).upline.emplace(upline_path{std::move(upline), true});
+  }
+
+  // - Next cursor for the following chunk (empty once the table is done)
+  print("next:", itr == adopters.end() ? name{} : itr->account);
+}//END backfill()
+
+// === Recount === //
+// --- Admin adds legacy adopters to their upline's referral counts --- //
+
+void invitono::recount(name from, uint32_t max_rows) {
+  // - Authorization check
+  const auto& cfg = _config.get();
+  check(has_auth(get_self()) || (cfg.admin != name{} && has_auth(cfg.admin)), "Only the contract or admin can recount");
+  check(max_rows > 0, "max_rows must be positive");
+
+  // - Walk one chunk; rows already counted still count toward max_rows
+  auto count = [&](const auto& stored) {
+    const adopter& row = *_adopters.find(stored.account.value);
+    if (row.referrals.has_value() && row.referrals->counted) return;
+
+    // - Counted the way a new registration is, every level at once
+    adopter marked = row;
+    referral_counts counts = marked.referrals.value_or();
+    counts.counted = true;
+    marked.referrals.emplace(counts);
+    _adopters.modify(row.account.value, growth_payer(row, marked)) = marked;
+    walk_upline(marked.invitedby, cfg.max_referral_depth, 1, [&](const adopter& ancestor, uint16_t level) {
+      adopter counted = ancestor;
+      count_downline(counted, level);
+      _adopters.modify(ancestor.account.value, growth_payer(ancestor, counted)) = std::move(counted);
+      return true;
+    });
+  };
+  auto walked = _adopters.walk(from.value, max_rows, count, count);
+
+  // - Next cursor for the following chunk (empty once both layouts are done)
+  print("next:", name(walked.next.value_or(0)));
+}//END recount()
+
+// === Prune === //
+// --- Admin shrinks claimed, idle adopters to tombstones --- //
+
+uint32_t invitono::prune(uint32_t max_rows, name cursor) {
+  // - Authorization check
+  const auto& cfg = _config.get();
+  check(has_auth(get_self()) || (cfg.admin != name{} && has_auth(cfg.admin)), "Only the contract or admin can prune");
+  check(max_rows > 0, "max_rows must be positive");
+
+  // - Rows are kept, not erased: a missing row could register and claim again, and
+  //   descendants step through it. Only the stored path goes; walks and child_upline
+  //   then follow invitedby as for legacy rows, so credits, counts and stats are unchanged
+  uint32_t now = current_time_point().sec_since_epoch();
+  uint32_t pruned = 0;
+  auto prune_row = [&](name account, bool in_old) {
+    const adopter& row = *_adopters.find(account.value);
+    if (!row.claimed || now - row.lastupdated < PRUNE_IDLE_SECONDS) return;
+
+    // - Tombstones only exist in the compact layout; legacy rows move there, paid by the contract
+    //   as in migrate, compact rows keep their payer
+    _adopters.modify(account.value).upline.emplace();
+    if (in_old) _adopters.migrate(account.value, get_self());
+    pruned++;
+  };
+
+  // - Walk one chunk; skipped rows count toward max_rows
+  auto walked = _adopters.walk(cursor.value, max_rows,
+    [&](const adopter& legacy) { prune_row(legacy.account, true); },
+    [&](const adopter_v2& compact) {
+      // - Already a tombstone, or nothing to drop
+      if ((compact.packed & PRUNED_BIT) != 0 || compact.upline.empty()) return;
+      prune_row(compact.account, false);
+    });
+
+  // - Next cursor for the following chunk (empty once both layouts are done)
+  print("next:", name(walked.next.value_or(0)));
+  return pruned;
+}//END prune()
+
+// === Backfill Upline === //
+// --- Path for a legacy row, taken from its inviter like a new registration --- //
+
+std::vector<name> invitono::backfill_upline(const adopter& row) {
+  std::vector<name> upline;
+  if (row.invitedby == name{}) return upline;
+
+  const adopter* inviter_row = _adopters.find(row.invitedby.value);
+  if (inviter_row != nullptr) {
+    upline = child_upline(*inviter_row, _config.get().max_referral_depth);
+  }
+  return upline;
+}//END backfill_upline()
+
+// === Set Mode === //
+// --- Admin sets lazy propagation and the inline level budget --- //
+
+void invitono::setmode(bool lazy_scores, uint16_t inline_levels) {
+  check(_config.exists(), "Contract is not configured");
+  require_auth(_config.get().admin);
+
+  // - Parameter validation (0 keeps the whole walk inline)
+  check(inline_levels <= 100, "Invalid inline levels (0-100)");
+
+  // - Switching back to eager keeps queueing until crank has drained the backlog
+  auto& current = _config.modify();
+  current.lazy_scores.emplace(lazy_scores);
+  current.inline_levels.emplace(inline_levels);
+}//END setmode()
+
+// === Set Log === //
+// --- Admin sets the change log retention --- //
+
+void invitono::setlog(uint32_t retention) {
+  // - Authorization check
+  const auto& cfg = _config.get();
+  check(has_auth(get_self()) || (cfg.admin != name{} && has_auth(cfg.admin)), "Only the contract or admin can set the log");
+
+  _changes.set_retention(retention);
+}//END setlog()
+
+// === Changes === //
+// --- Read-only page of the change log --- //
+
+change_page invitono::changes(uint64_t since_seq, uint32_t max) {
+  check(max > 0 && max <= changelog::MAX_PAGE, "Invalid max (1-" + std::to_string(changelog::MAX_PAGE) + ")");
+  return _changes.read(since_seq, max);
+}//END changes()
+
+// === Crank === //
+// --- Permissionless: applies queued credits oldest first --- //
+
+void invitono::crank(uint32_t max_items) {
+  check(max_items > 0, "max_items must be positive");
+  check(apply_credits(max_items) > 0, "No queued credits");
+}//END crank()
+
+// === Get Score === //
+// --- Read-only score with queued credits applied --- //
+
+uint32_t invitono::getscore(name user) {
+  const adopter* row = _adopters.find(user.value);
+  check(row != nullptr, "User not found");
+
+  adopter current = *row;
+  check(with_pending(current), "Too many credits queued, run crank first");
+  return current.score;
+}//END getscore()
+
+// === Get User === //
+// --- Read-only summary of one adopter, queued credits applied --- //
+
+invitono::user_summary invitono::getuser(name user) {
+  const adopter* row = _adopters.find(user.value);
+  check(row != nullptr, "User not found");
+  const auto& cfg = _config.get();
+
+  // - Same view claimreward takes: stored row plus the queued credits that reach it, as far
+  //   as the read limit goes
+  adopter current = *row;
+  bool settled = with_pending(current);
+  uint32_t since = current_time_point().sec_since_epoch() - current.lastupdated;
+
+  user_summary summary;
+  summary.account = user;
+  summary.score = current.score;
+  summary.claimed = current.claimed;
+  summary.cooldown_remaining = since < cfg.invite_rate_seconds ? cfg.invite_rate_seconds - since : 0;
+  summary.position = calculate_tetrahedral_position(current.score);
+  summary.reward = current.claimed ? asset(0, cfg.reward_symbol) : reward_for(summary.position, cfg);
+  summary.direct = current.referrals.value_or().direct;
+  summary.downline = current.referrals.value_or().downline;
+  summary.settled = settled;
+  return summary;
+}//END getuser()
+
+// === Leaderboard === //
+// --- Read-only page of the live snapshot by score, highest first, ties by account --- //
+
+invitono::leaderboard_page invitono::leaderboard(uint32_t after_score, name after_account, uint32_t limit) {
+  check(limit > 0 && limit <= MAX_LEADERBOARD_PAGE, "Invalid limit (1-" + std::to_string(MAX_LEADERBOARD_PAGE) + ")");
+
+  counted_t<lbstate_table> progress(get_self(), get_self().value);
+  counted_t<leaderboard_table> board(get_self(), progress.get_or_default().live);
+  auto index = board.get_index<"byscore"_n>();
+
+  // - (score, account) is one key, so the cursor is a single upper_bound
+  auto itr = after_account == name{} ? index.begin() : index.upper_bound(leader::score_key(after_score, after_account));
+
+  leaderboard_page page;
+  page.leaders.reserve(limit);
+  for (; itr != index.end() && page.leaders.size() < limit; ++itr) {
+    page.leaders.push_back(*itr);
+  }
+
+  page.more = itr != index.end();
+  return page;
+}//END leaderboard()
+
+// === Refresh Leaderboard === //
+// --- Permissionless: clears the spare snapshot, refills it from both layouts, then swaps --- //
+
+uint32_t invitono::refreshlb(uint32_t max_rows) {
+  check(max_rows > 0, "max_rows must be positive");
+
+  counted_t<lbstate_table> progress(get_self(), get_self().value);
+  lbstate state = progress.get_or_default();
+  counted_t<leaderboard_table> board(get_self(), state.live ^ 1);
+
+  // - Clearing and scanning share the budget, so a chunk's cost is bounded either way
+  uint32_t processed = 0;
+  if (!state.filling) {
+    for (auto itr = board.begin(); itr != board.end() && processed < max_rows; processed++) {
+      itr = board.erase(itr);
+    }
+    if (board.begin() == board.end()) {
+      state.filling = true;
+      state.cursor = name{};
+      state.size = 0;
+    }
+  }
+
+  if (state.filling) {
+    auto index = board.get_index<"byscore"_n>();
+    auto rank = [&](const leader& row) {
+      // - Full: the row only goes in by displacing the lowest entry
+      if (state.size >= LEADERBOARD_SIZE) {
+        auto lowest = std::prev(index.end());
+        if (lowest->by_score() <= row.by_score()) return;
+        board.erase(board.find(lowest->account.value));
+        state.size--;
+      }
+      board.emplace(get_self(), [&](auto& entry) { entry = row; });
+      state.size++;
+    };
+    auto walked = _adopters.walk(state.cursor.value, max_rows - processed,
+      [&](const adopter& legacy) { rank({legacy.account, legacy.score}); },
+      [&](const adopter_v2& compact) { rank({compact.account, compact.score.value}); });
+    processed += walked.visited;
+
+    // - Both layouts done: the refilled scope goes live and the old one is cleared next pass
+    state.cursor = name(walked.next.value_or(0));
+    if (!walked.next.has_value()) {
+      state.live ^= 1;
+      state.filling = false;
+      state.refreshed = current_time_point().sec_since_epoch();
+    }
+  }
+
+  progress.set(state, get_self());
+  return processed;
+}//END refreshlb()
+
+// === Get Referrals === //
+// --- Read-only page of one inviter's direct referrals, by account --- //
+
+invitono::referral_page invitono::getreferrals(name inviter, name after, uint32_t limit) {
+  check(limit > 0 && limit <= MAX_LEADERBOARD_PAGE, "Invalid limit (1-" + std::to_string(MAX_LEADERBOARD_PAGE) + ")");
+
+  // - The inviter's referrals are one key range; an empty after starts at its first account
+  auto index = _adopters.new_table().get_index<"byinviter"_n>();
+  auto itr = after == name{} ? index.lower_bound(adopter_v2::inviter_key(inviter, name{}))
+                             : index.upper_bound(adopter_v2::inviter_key(inviter, after));
+
+  referral_page page;
+  page.referrals.reserve(limit);
+  for (; itr != index.end() && itr->invitedby == inviter && page.referrals.size() < limit; ++itr) {
+    referral_counts counts = itr->referrals.value_or();
+    page.referrals.push_back({itr->account, itr->score.value, counts.direct, counts.downline});
+  }
+
+  page.more = itr != index.end() && itr->invitedby == inviter;
+  return page;
+}//END getreferrals()
+
+// === Export Adopters === //
+// --- Read-only binary page of adopters for off-chain indexers --- //
+
+invitono::export_page invitono::exportadopt(uint64_t cursor, uint32_t limit) {
+  check(limit > 0 && limit <= snapshot::MAX_PAGE_ROWS, "Invalid limit (1-" + std::to_string(snapshot::MAX_PAGE_ROWS) + ")");
+
+  // - Rows are read straight off the tables, nothing goes through the row cache
+  export_page page;
+  page.rows.reserve(limit * snapshot::ADOPTER_RECORD_SIZE);
+  auto walked = _adopters.walk(cursor, limit,
+    [&](const adopter& legacy) {
+      snapshot::append(page.rows, snapshot::adopter_record{legacy.account.value, legacy.invitedby.value, legacy.score, legacy.claimed ? snapshot::CLAIMED : 0u});
+    },
+    [&](const adopter_v2& compact) {
+      uint32_t flags = snapshot::COMPACT | ((compact.packed & CLAIMED_BIT) ? snapshot::CLAIMED : 0u) |
+                       ((compact.packed & PRUNED_BIT) ? snapshot::PRUNED : 0u);
+      snapshot::append(page.rows, snapshot::adopter_record{compact.account.value, compact.invitedby.value, compact.score.value, flags});
+    });
+
+  // - Cursor is the first account of the next page
+  page.cursor = walked.next.value_or(0);
+  page.more = walked.next.has_value();
+  page.settled = _credits.begin() == _credits.end();
+  return page;
+}//END exportadopt()
+
+// === Get Stats === //
+// --- Read-only totals: stats singleton plus every shard --- //
+
+invitono::stats invitono::getstats() {
+  counted_t<stats_table> legacy(get_self(), get_self().value);
+  stats totals = legacy.get_or_default();
+
+  // - Shards only hold registrations made after sharding, so the legacy
+  //   last_registered stands until a shard has one
+  uint32_t latest = 0;
+  for (const auto& shard : _shards.table()) {
+    totals.total_users += shard.total_users;
+    totals.total_referrals += shard.total_referrals;
+    if (shard.last_registered_at >= latest && shard.last_registered != name{}) {
+      latest = shard.last_registered_at;
+      totals.last_registered = shard.last_registered;
+    }
+  }
+  return totals;
+}//END getstats()
+
+// === Migrate === //
+// --- Admin moves one chunk of adopters to the compact layout --- //
+
+uint32_t invitono::migrate(uint32_t max_rows) {
+  // - Authorization check
+  const auto& cfg = _config.get();
+  check(has_auth(get_self()) || (cfg.admin != name{} && has_auth(cfg.admin)), "Only the contract or admin can migrate");
+  check(max_rows > 0, "max_rows must be positive");
+
+  counted_t<migration_table> progress(get_self(), get_self().value);
+  migration state = progress.get_or_default();
+  check(!state.done, "Migration is complete");
+
+  auto& adopters = _adopters.old_table();
+  auto itr = adopters.lower_bound(state.cursor.value);
+
+  // - Moves happen at flush, so the old table can be walked while they are queued
+  uint32_t moved = 0;
+  for (; itr != adopters.end() && moved < max_rows; itr++) {
+    const adopter& row = *_adopters.find(itr->account.value);
+
+    // - The compact layout has no legacy form, so missing paths are filled on the way
+    if (!has_path(row)) {
+      std::vector<name> upline = backfill_upline(row);
+      _adopters.modify(row.account.value).upline.emplace(upline_path{std::move(upline), true});
+    }
+
+    // - Contract pays for the compact row, the original payer did not sign
+    if (_adopters.migrate(row.account.value, get_self())) moved++;
+  }
+
+  state.cursor = itr == adopters.end() ? name{} : itr->account;
+  state.done = itr == adopters.end();
+  progress.set(state, get_self());
+  return moved;
+}//END migrate()
+
+// === Adopter Codec === //
+// --- Converts rows between the adopter and adopter_v2 layouts --- //
+
+invitono::adopter_v2 invitono::adopter_codec::pack(const adopter& row) {
+  // - Timestamps before the epoch are long past any cooldown, so they are stored as the epoch
+  uint32_t lastupdated = std::max(row.lastupdated, CONTRACT_EPOCH) - CONTRACT_EPOCH;
+  check(lastupdated < PRUNED_BIT, "Timestamp out of range for the compact layout");
+
+  adopter_v2 packed;
+  packed.account = row.account;
+  packed.invitedby = row.invitedby;
+  // - A row without a path is a tombstone; new and migrated rows always carry one
+  packed.packed = lastupdated | (row.claimed ? CLAIMED_BIT : 0) | (has_path(row) ? 0 : PRUNED_BIT);
+  packed.score = row.score;
+  packed.upline = row.upline.value_or().ancestors;
+  if (row.referrals.has_value()) packed.referrals.emplace(row.referrals.value());
+  return packed;
+}//END adopter_codec::pack()
+
+invitono::adopter invitono::adopter_codec::unpack(const adopter_v2& row) {
+  adopter unpacked;
+  unpacked.account = row.account;
+  unpacked.invitedby = row.invitedby;
+  unpacked.lastupdated = (row.packed & ~(CLAIMED_BIT | PRUNED_BIT)) + CONTRACT_EPOCH;
+  unpacked.score = row.score.value;
+  unpacked.claimed = (row.packed & CLAIMED_BIT) != 0;
+  // - Tombstones keep an empty path that is not filled
+  unpacked.upline.emplace(upline_path{row.upline, (row.packed & PRUNED_BIT) == 0});
+  if (row.referrals.has_value()) unpacked.referrals.emplace(row.referrals.value());
+  return unpacked;
+}//END adopter_codec::unpack()
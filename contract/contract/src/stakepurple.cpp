@@ -1,4 +1,37 @@
 #include "stakepurple.hpp"
+
+/**
+ * @title Action State
+ * @details Table handles are built once per action; rows load on first use
+ * and every change is written back by the destructor.
+ */
+stakepurple::stakepurple(name receiver, name code, datastream<const char*> ds)
+    : contract(receiver, code, ds), _configs(receiver, receiver.value), _stats(receiver, receiver.value), _slots(receiver),
+      _stakers(receiver, receiver.value), _changes(receiver) {}
+
+stakepurple::~stakepurple() {
+    // Every written row is logged once for indexers, except the totals, which tokenstats serves
+    _configs.flush([&](uint64_t code) { _changes.append(changelog::CONFIG, name(), code); });
+    _stats.flush();
+    for (auto& entry : _stakes) {
+        const name& user = entry.first;
+        entry.second.flush([&](uint64_t code) { _changes.append(changelog::STAKE, user, code); });
+    }
+    _stakers.flush();
+    _changes.flush();
+
+    // Counts of the whole action, write-back included (instrumented builds only)
+    instrumentation::report();
+}
+
+auto stakepurple::stakes_of(const name& user) -> stakes_table& {
+    auto itr = _stakes.find(user);
+    if (itr == _stakes.end()) {
+        itr = _stakes.emplace(std::piecewise_construct, std::forward_as_tuple(user), std::forward_as_tuple(get_self(), user.value, stake_codec{&_slots})).first;
+    }
+    return itr->second;
+}
+
 /**
  * @title Set Staking Parameters
  * @abi action setparams
@@ -17,6 +50,8 @@
  * @pre token_contract must be valid account
  * @pre unstake_period must be > 0
  * @pre reward_rate must be > 0
+ * @post token_symbol is in the allowlist under token_contract. Tokens configured before the
+ * allowlist existed are listed by listtokens, or by running setparams for them again.
  */
 ACTION stakepurple::setparams(const name& user, const symbol& token_symbol, const name& token_contract ,const symbol& reward_token_symbol, const name& reward_token_contract, const uint32_t& unstake_period, const uint32_t& reward_rate = 100) {
     require_auth(get_self());
@@ -26,34 +61,101 @@ ACTION stakepurple::setparams(const name& user, const symbol& token_symbol, cons
     check(token_symbol.is_valid(), "🔯 Invalid token symbol");
     check(reward_token_symbol.is_valid(), "🔯 Invalid reward token symbol");
 
-    config_t config_tbl(get_self(), get_self().value);
-    
     // Check if reward token is already configured as a stakeable token
-    auto existing_token = config_tbl.find(reward_token_symbol.code().raw());
-    check(existing_token == config_tbl.end(), "🔯 Reward token cannot be an existing stakeable token");
+    check(_configs.find(reward_token_symbol.code().raw()) == nullptr, "🔯 Reward token cannot be an existing stakeable token");
 
-    auto config_itr = config_tbl.find(token_symbol.code().raw());
-
-    if (config_itr == config_tbl.end()) {
-        config_tbl.emplace(get_self(), [&](auto& row) {
-            row.creator = user;
-            row.token_contract = token_contract;
-            row.token_symbol = token_symbol;
-            row.reward_token_contract = reward_token_contract;
-            row.reward_token_symbol = reward_token_symbol;
-            row.unstake_period = unstake_period;
-            row.reward_rate = reward_rate;
-        });
+    if (_configs.find(token_symbol.code().raw()) == nullptr) {
+        config row;
+        row.creator = user;
+        row.token_contract = token_contract;
+        row.token_symbol = token_symbol;
+        row.reward_token_contract = reward_token_contract;
+        row.reward_token_symbol = reward_token_symbol;
+        row.unstake_period = unstake_period;
+        row.reward_rate = reward_rate;
+        row.index.emplace(reward_index{0, 0, time_point_sec(current_time_point())});
+        _configs.emplace(get_self(), row);
     } else {
-        config_tbl.modify(config_itr, get_self(), [&](auto& row) {
-            row.token_contract = token_contract;
-            row.token_symbol = token_symbol;
-            row.reward_token_contract = reward_token_contract;
-            row.reward_token_symbol = reward_token_symbol;
-            row.unstake_period = unstake_period;
-            row.reward_rate = reward_rate;
-        });
+        // Earlier time keeps the old rate
+        close_epoch(token_symbol.code());
+        auto& row = _configs.modify(token_symbol.code().raw(), get_self());
+        if (row.token_contract != token_contract) {
+            set_allowed(row.token_contract, token_symbol.code(), false);
+        }
+        row.token_contract = token_contract;
+        row.token_symbol = token_symbol;
+        row.reward_token_contract = reward_token_contract;
+        row.reward_token_symbol = reward_token_symbol;
+        row.unstake_period = unstake_period;
+        row.reward_rate = reward_rate;
     }
+
+    set_allowed(token_contract, token_symbol.code(), true);
+}
+
+/**
+ * @title Set Memo Mode
+ * @abi action setmemo
+ * @details Chooses the memo written on reward transfers for a staked token
+ *
+ * @param token_symbol - The staked token symbol
+ * @param memo_mode - MEMO_FULL, MEMO_COMPACT or MEMO_EMPTY
+ *
+ * @pre Requires contract authority
+ * @pre Token must be configured
+ */
+ACTION stakepurple::setmemo(const symbol& token_symbol, const uint8_t& memo_mode) {
+    require_auth(get_self());
+
+    check(memo_mode <= MEMO_EMPTY, "🔯 Invalid memo mode (0 full, 1 compact, 2 empty)");
+    check(_configs.find(token_symbol.code().raw()) != nullptr, "🔯 Token configuration not found");
+
+    _configs.modify(token_symbol.code().raw(), get_self()).memo_mode.emplace(memo_mode);
+}
+
+/**
+ * @title Set Log
+ * @abi action setlog
+ * @details Sets the change log retention
+ *
+ * @param retention - Entries kept (0 turns the log off)
+ *
+ * @pre Requires contract authority
+ */
+ACTION stakepurple::setlog(const uint32_t& retention) {
+    require_auth(get_self());
+
+    _changes.set_retention(retention);
+}
+
+/**
+ * @title Changes
+ * @abi action changes
+ * @details Read-only page of the change log, oldest first
+ *
+ * @param since_seq - Last sequence already seen
+ * @param max - Entries returned
+ * @return Entries, the oldest kept and next sequence, and whether more follow
+ *
+ * @pre max must be between 1 and changelog::MAX_PAGE
+ */
+change_page stakepurple::changes(const uint64_t& since_seq, const uint32_t& max) {
+    check(max > 0 && max <= changelog::MAX_PAGE, "🔯 Invalid max (1-" + std::to_string(changelog::MAX_PAGE) + ").");
+    return _changes.read(since_seq, max);
+}
+
+/**
+ * @title Log Claim
+ * @abi action logclaim
+ * @details Receipt sent inline by process_claim; it only records its arguments in the action trace
+ *
+ * @param user - The account that was paid
+ * @param receipts - One entry per stake paid
+ *
+ * @pre Requires contract authority
+ */
+ACTION stakepurple::logclaim(const name& user, const std::vector<claim_receipt>& receipts) {
+    require_auth(get_self());
 }
 
 /**
@@ -79,19 +181,20 @@ ACTION stakepurple::unstake(const name& user, const asset& quantity) {
     require_auth(user);
 
     // Verify token configuration exists and get it
-    config_t config_tbl(get_self(), get_self().value);
-    auto config_itr = config_tbl.require_find(quantity.symbol.code().raw(), 
-        ("🔯 Token configuration not found for symbol: " + quantity.symbol.code().to_string()).c_str());
+    const config* config_itr = _configs.find(quantity.symbol.code().raw());
+    check(config_itr != nullptr, "🔯 Token configuration not found for symbol: " + quantity.symbol.code().to_string());
 
-    // Only process claims if the token is not paused
+    // Only process claims if the token is not paused; rewards are credited, withdraw pays them
     if (!config_itr->is_paused) {
-        process_claim(user, false);
+        process_claim(user, false, false);
     }
 
     // Initialize stakes table in user's scope
-    stake_t stake_tbl(get_self(), user.value);
-    auto stake_itr = stake_tbl.require_find(quantity.symbol.code().raw(),
-        ("🔯 No staked tokens found for " + user.to_string() + " with symbol " + quantity.symbol.code().to_string()).c_str());
+    auto& stake_tbl = stakes_of(user);
+    const stake_s* stake_itr = stake_tbl.find(quantity.symbol.code().raw());
+    check(stake_itr != nullptr, "🔯 No staked tokens found for " + user.to_string() + " with symbol " + quantity.symbol.code().to_string());
+    // Also when paused, where no claim registered them
+    register_staker(user);
 
     // Validate staked amount
     check(stake_itr->staked_amount.symbol == quantity.symbol, "🔯 Symbol mismatch");
@@ -113,23 +216,41 @@ ACTION stakepurple::unstake(const name& user, const asset& quantity) {
         check(false, error_msg);
     }
 
+    // Copied out before the stake changes; the cache keeps config_itr valid but not stake_itr
+    name token_contract = config_itr->token_contract;
+
     // Update or erase stake
     if ((stake_itr->staked_amount.amount - quantity.amount) == 0) {
-        stake_tbl.erase(stake_itr);
-    } else {
-        stake_tbl.modify(stake_itr, get_self(), [&](auto& row) {
-            row.staked_amount -= quantity;
-            check(row.staked_amount.amount > 0, "🔯 Staked amount must be positive");
+        stake_tbl.erase(quantity.symbol.code().raw());
+        count_stake(user, -quantity, -1);
+
+        // Leave the registry with the last stake
+        std::vector<uint64_t> keys = stake_tbl.keys();
+        bool has_stakes = std::any_of(keys.begin(), keys.end(), [&](uint64_t pk) {
+            return stake_tbl.find(pk) != nullptr;
         });
+        if (!has_stakes && _stakers.find(user.value) != nullptr) {
+            _stakers.erase(user.value);
+        }
+    } else {
+        auto& row = stake_tbl.modify(quantity.symbol.code().raw(), get_self());
+        // A paused token was not settled above; a stake from before the index keeps its days through its checkpoint
+        if (!row.checkpoint.has_value()) {
+            row.checkpoint.emplace(checkpoint_of(row, *config_itr, index_of(quantity.symbol.code())));
+        }
+        row.staked_amount -= quantity;
+        check(row.staked_amount.amount > 0, "🔯 Staked amount must be positive");
+        count_stake(user, -quantity, 0);
     }
 
     // Send tokens back to user
     action(
         permission_level{get_self(), "active"_n},
-        config_itr->token_contract,
+        token_contract,
         "transfer"_n,
         std::make_tuple(get_self(), user, quantity, std::string("🔯 Here's your PURPLE back 🍄"))
     ).send();
+    instrumentation::inline_sent();
 }
 
 /**
@@ -155,6 +276,300 @@ ACTION stakepurple::claim(const name& user) {
     process_claim(user);
 }
 
+/**
+ * @title Withdraw
+ * @abi action withdraw
+ * @details Pays out the rewards credited by top-ups and unstakes, one transfer per reward token
+ *
+ * @param user - The account to pay
+ *
+ * @pre Requires user or contract authority
+ * @pre The user must have credited rewards
+ */
+ACTION stakepurple::withdraw(const name& user) {
+    if (!has_auth(get_self())) {
+        require_auth(user);
+    }
+
+    check(pay_rewards(user) > 0, "🔯 No rewards to withdraw.");
+}
+
+/**
+ * @title Claim Batch
+ * @abi action claimbatch
+ * @details Claims for registered stakers in account order, starting at cursor
+ *
+ * @param cursor - First staker to visit (empty name starts from the beginning)
+ * @param max_users - Stakers visited in this transaction
+ * @return Next cursor, or an empty name once the registry is done
+ *
+ * @pre Requires contract authority, like claims made on a user's behalf
+ * @pre max_users must be > 0
+ */
+name stakepurple::claimbatch(const name& cursor, const uint32_t& max_users) {
+    // Claims reset the unstake period, so only the contract may claim for others
+    require_auth(get_self());
+    check(max_users > 0, "🔯 max_users must be positive");
+
+    auto& registry = _stakers.table();
+    auto itr = registry.lower_bound(cursor.value);
+
+    for (uint32_t visited = 0; itr != registry.end() && visited < max_users; visited++, itr++) {
+        if (can_claim(itr->account)) {
+            process_claim(itr->account);
+        }
+    }
+
+    return itr == registry.end() ? name() : itr->account;
+}
+
+/**
+ * @title Export Stakes
+ * @abi action exportstakes
+ * @details Returns up to `limit` stakes as fixed-layout records, walking the staker registry from the cursor
+ *
+ * @param cursor - Staker in the high half, first symbol code to return in the low half (0 starts from the beginning)
+ * @param limit - Stakes returned
+ * @return Records, the cursor of the next page and whether one remains
+ *
+ * @pre limit must be between 1 and snapshot::MAX_PAGE_ROWS
+ */
+stakepurple::stake_page stakepurple::exportstakes(const uint128_t& cursor, const uint32_t& limit) {
+    check(limit > 0 && limit <= snapshot::MAX_PAGE_ROWS, "🔯 Invalid limit (1-" + std::to_string(snapshot::MAX_PAGE_ROWS) + ").");
+
+    const uint64_t first_staker = static_cast<uint64_t>(cursor >> 64);
+    const uint64_t first_code = static_cast<uint64_t>(cursor);
+
+    stake_page page;
+    page.rows.reserve(limit * snapshot::STAKE_RECORD_SIZE);
+    uint32_t count = 0;
+
+    auto& registry = _stakers.table();
+    for (auto itr = registry.lower_bound(first_staker); itr != registry.end(); itr++) {
+        // A staker holds a few tokens: both layouts are read straight off the tables and sorted by symbol code
+        std::vector<snapshot::stake_record> stakes;
+        counted_t<stake_t> legacy(get_self(), itr->account.value);
+        for (const auto& row : legacy) {
+            stakes.push_back({itr->account.value, row.staked_amount.symbol.raw(), row.staked_amount.amount, row.last_claim.sec_since_epoch()});
+        }
+        counted_t<stake_v2_t> compact(get_self(), itr->account.value);
+        for (const auto& row : compact) {
+            stakes.push_back({itr->account.value, _slots.get(row.slot).raw(), row.amount, row.last_claim + CONTRACT_EPOCH});
+        }
+        std::sort(stakes.begin(), stakes.end(), [](const auto& a, const auto& b) {
+            return symbol(a.symbol).code().raw() < symbol(b.symbol).code().raw();
+        });
+
+        for (const auto& record : stakes) {
+            const uint64_t code = symbol(record.symbol).code().raw();
+            if (itr->account.value == first_staker && code < first_code) continue;
+
+            // Full: resume at this stake
+            if (count == limit) {
+                page.cursor = (static_cast<uint128_t>(itr->account.value) << 64) | code;
+                page.more = true;
+                return page;
+            }
+            snapshot::append(page.rows, record);
+            count++;
+        }
+    }
+    return page;
+}
+
+/**
+ * @title Add Stakers
+ * @abi action addstakers
+ * @details Registers accounts that staked before the registry existed
+ *
+ * @param users - Accounts to register
+ *
+ * @pre Requires contract authority
+ */
+ACTION stakepurple::addstakers(const std::vector<name>& users) {
+    require_auth(get_self());
+
+    for (const auto& user : users) {
+        if (!stakes_of(user).keys().empty()) {
+            register_staker(user);
+        }
+    }
+}
+
+/**
+ * @title List Tokens
+ * @abi action listtokens
+ * @details Adds every configured token to the allowlist under its token contract
+ *
+ * @pre Requires contract authority
+ * @post Tokens configured before the allowlist existed are staked by on_transfer
+ */
+ACTION stakepurple::listtokens() {
+    require_auth(get_self());
+
+    for (const auto& row : _configs.table()) {
+        set_allowed(row.token_contract, row.token_symbol.code(), true);
+    }
+}
+
+/**
+ * @title Migrate
+ * @abi action migrate
+ * @details Moves the stakes of registered stakers to the compact layout, in staker order from the stored cursor
+ *
+ * @param max_rows - Stakes visited in this transaction
+ * @return Number of stakes moved
+ *
+ * @pre Requires contract authority
+ * @pre max_rows must be > 0
+ * @pre Stakers from before the registry must be added with addstakers first
+ */
+uint32_t stakepurple::migrate(const uint32_t& max_rows) {
+    require_auth(get_self());
+    check(max_rows > 0, "🔯 max_rows must be positive");
+
+    counted_t<migration_t> progress(get_self(), get_self().value);
+    migration_state state = progress.get_or_default();
+    check(!state.done, "🔯 Migration is complete");
+
+    auto& registry = _stakers.table();
+    auto itr = registry.lower_bound(state.cursor.value);
+
+    // Moves happen at flush, so the old stakes can be walked while they are queued.
+    // A staker without old stakes still counts as one row, so the chunk stays bounded
+    uint32_t moved = 0;
+    for (uint32_t visited = 0; itr != registry.end() && visited < max_rows; itr++) {
+        auto& stakes = stakes_of(itr->account);
+        uint32_t rows = 0;
+        for (const auto& row : stakes.old_table()) {
+            rows++;
+            // The compact layout has no stake without a checkpoint, so one is given on the way
+            const stake_s* stake_itr = stakes.find(row.primary_key());
+            if (!stake_itr->checkpoint.has_value()) {
+                const symbol_code code = stake_itr->staked_amount.symbol.code();
+                const config* config_itr = _configs.find(code.raw());
+                check(config_itr != nullptr, "🔯 Token configuration not found.");
+                stake_checkpoint checkpoint = checkpoint_of(*stake_itr, *config_itr, index_of(code));
+                stakes.modify(row.primary_key()).checkpoint.emplace(checkpoint);
+            }
+            // Contract pays, as it does for every stake
+            if (stakes.migrate(row.primary_key(), get_self())) moved++;
+        }
+        visited += std::max<uint32_t>(rows, 1);
+    }
+
+    state.cursor = itr == registry.end() ? name() : itr->account;
+    state.done = itr == registry.end();
+    progress.set(state, get_self());
+    return moved;
+}
+
+/**
+ * @title Count Stakes
+ * @abi action countstakes
+ * @details Adds the stakes of registered stakers to the token totals, in staker order from the stored cursor
+ *
+ * @param max_rows - Stakes visited in this transaction
+ * @return Number of stakes counted
+ *
+ * @pre Requires contract authority
+ * @pre max_rows must be > 0
+ * @pre Stakers from before the registry must be added with addstakers first
+ */
+uint32_t stakepurple::countstakes(const uint32_t& max_rows) {
+    require_auth(get_self());
+    check(max_rows > 0, "🔯 max_rows must be positive");
+
+    counted_t<count_t> progress(get_self(), get_self().value);
+    count_state state = progress.get_or_default();
+    check(!state.done, "🔯 Stakes are already counted");
+
+    auto& registry = _stakers.table();
+    auto itr = registry.lower_bound(state.cursor.value);
+
+    // Stakers are taken whole, as in migrate, so each one is counted exactly once
+    uint32_t counted = 0;
+    for (uint32_t visited = 0; itr != registry.end() && visited < max_rows; itr++) {
+        uint32_t stakes = count_staker(itr->account);
+        counted += stakes;
+        visited += std::max<uint32_t>(stakes, 1);
+    }
+
+    state.cursor = itr == registry.end() ? name() : itr->account;
+    state.done = itr == registry.end();
+    progress.set(state, get_self());
+    return counted;
+}
+
+/**
+ * @title Token Stats
+ * @abi action tokenstats
+ * @details Read-only totals of every configured token
+ *
+ * @return One entry per token, and whether countstakes has finished
+ */
+stakepurple::totals_page stakepurple::tokenstats() {
+    totals_page page;
+    for (const auto& row : _configs.table()) {
+        const token_stats* counted = _stats.find(row.primary_key());
+        token_stats stats = counted != nullptr ? *counted : token_stats{};
+        page.tokens.push_back({
+            asset(stats.total_staked, row.token_symbol),
+            stats.stakers,
+            row.reward_token_contract,
+            asset(stats.rewards_paid, row.reward_token_symbol)
+        });
+    }
+
+    counted_t<count_t> progress(get_self(), get_self().value);
+    page.complete = progress.get_or_default().done;
+    return page;
+}
+
+/**
+ * @title Get Stakes
+ * @abi action getstakes
+ * @details Read-only stakes of one account, read through both layouts
+ *
+ * @param user - The staker
+ * @return The user's stakes by symbol code
+ */
+std::vector<stakepurple::user_stake> stakepurple::getstakes(const name& user) {
+    auto& stakes = stakes_of(user);
+    std::vector<uint64_t> keys = stakes.keys();
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<user_stake> result;
+    for (uint64_t pk : keys) {
+        const stake_s* stake_itr = stakes.find(pk);
+        result.push_back({stake_itr->staked_amount, stake_itr->last_claim});
+    }
+    return result;
+}
+
+/**
+ * @title Get Rewards
+ * @abi action getrewards
+ * @details Read-only breakdown of what a claim would pay now for each stake of one account, read through both layouts
+ *
+ * @param user - The staker
+ * @return One receipt per stake, by symbol code
+ */
+std::vector<stakepurple::claim_receipt> stakepurple::getrewards(const name& user) {
+    auto& stakes = stakes_of(user);
+    std::vector<uint64_t> keys = stakes.keys();
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<claim_receipt> result;
+    for (uint64_t pk : keys) {
+        const stake_s* stake_itr = stakes.find(pk);
+        const config* config_itr = _configs.find(stake_itr->staked_amount.symbol.code().raw());
+        check(config_itr != nullptr, "🔯 Token configuration not found.");
+        result.push_back(receipt_of(*stake_itr, *config_itr, current_index(*config_itr)));
+    }
+    return result;
+}
+
 /**
  * @title Token Transfer Handler
  * @details Handles incoming token transfers for staking
@@ -171,59 +586,47 @@ ACTION stakepurple::claim(const name& user) {
  */
 [[eosio::on_notify("*::transfer")]]
 void stakepurple::on_transfer(name from, name to, asset quantity, std::string memo) {
-    if (from == get_self()) return;
+    if (from == get_self() || to != get_self()) return;
+
+    // Airdrops and spam stop here: one small row and one config row, no memo parsing
+    counted_t<allowlist_t> allowlist(get_self(), get_self().value);
+    auto allowed = allowlist.find(get_first_receiver().value);
+    bool listed = allowed != allowlist.end() &&
+        std::find(allowed->symbols.begin(), allowed->symbols.end(), quantity.symbol.code()) != allowed->symbols.end();
+    if (!listed) return;
 
     check(quantity.symbol.is_valid(), "Invalid symbol");
+    check(quantity.amount > 1, "🔯 Must transfer more than one token.");
+
+    // Handle "for:" memo to stake for another account (spaces around the name are ignored)
+    std::string_view text(memo);
+    if (text.substr(0, 4) == "for:") {
+        text.remove_prefix(4);
+        size_t first = text.find_first_not_of(' ');
+        text = first == std::string_view::npos ? std::string_view() : text.substr(first, text.find_last_not_of(' ') - first + 1);
 
-    // Handle "for:" memo to stake for another account
-    if (memo.substr(0, 4) == "for:" || memo.substr(0, 5) == "for: ") {
-        string account_str = memo.substr(memo.find(":") + 1);
-        // Trim leading spaces
-        account_str.erase(0, account_str.find_first_not_of(" "));
-        // Trim trailing spaces
-        account_str.erase(account_str.find_last_not_of(" ") + 1);
-        
         // Verify the account name is valid
-        check(account_str.length() <= 12, "🔯 Invalid account name length in memo");
-        from = name(account_str);
+        check(text.length() <= 12, "🔯 Invalid account name length in memo");
+        from = name(text);
         check(is_account(from), "🔯 Account specified in memo does not exist");
     }
 
-    config_t config_tbl(get_self(), get_self().value);
-    auto by_reward = config_tbl.get_index<"byreward"_n>();
-    
-    // Check if token is stakeable
-    auto primary_itr = config_tbl.find(quantity.symbol.code().raw());
-    bool is_stakeable = (primary_itr != config_tbl.end() && 
-                        get_first_receiver() == primary_itr->token_contract);
-    
-    /*/ Check if token is reward token
-    auto reward_itr = by_reward.find(quantity.symbol.code().raw());
-    bool is_reward = (reward_itr != by_reward.end() && 
-                     get_first_receiver() == reward_itr->reward_token_contract);
-    
-    check(is_stakeable || is_reward, "Token " + get_first_receiver().to_string() + "::" + quantity.symbol.code().to_string() + " isn't configured as a reward or stakable token");
-    */
-
-    if (!is_stakeable) {
-        return;
-    }
-
-    check(quantity.amount > 1, "🔯 Must transfer more than one token.");
+    auto& stake_tbl = stakes_of(from);
 
-    stake_t stake_tbl(get_self(), from.value);
-    auto stake_itr = stake_tbl.find(quantity.symbol.code().raw());
-
-    if (stake_itr == stake_tbl.end()) {
-        stake_tbl.emplace(get_self(), [&](auto& row) {
-            row.staked_amount = quantity;
-            row.last_claim = time_point_sec(current_time_point());
-        });
+    if (stake_tbl.find(quantity.symbol.code().raw()) == nullptr) {
+        // Registered first, so a staker joining behind the countstakes cursor is not counted twice
+        register_staker(from);
+        stake_s row;
+        row.staked_amount = quantity;
+        row.last_claim = time_point_sec(current_time_point());
+        reward_index index = index_of(quantity.symbol.code());
+        row.checkpoint.emplace(stake_checkpoint{index.rate_seconds, index.active_seconds});
+        stake_tbl.emplace(get_self(), row);
+        count_stake(from, quantity, 1);
     } else {
-        process_claim(from, false);  // Process claim before adding new stake
-        stake_tbl.modify(stake_itr, get_self(), [&](auto& row) {
-            row.staked_amount += quantity;
-        });
+        process_claim(from, false, false);  // Settle into the ledger before adding new stake
+        stake_tbl.modify(quantity.symbol.code().raw(), get_self()).staked_amount += quantity;
+        count_stake(from, quantity, 0);
     }
 }
 
@@ -239,103 +642,432 @@ void stakepurple::on_transfer(name from, name to, asset quantity, std::string me
 ACTION stakepurple::pause(bool should_pause, const name token_contract, const symbol token_symbol) {
     require_auth(get_self());
     
-    config_t config_tbl(get_self(), get_self().value);
-    
     // If token_contract is empty name or token_symbol is empty/ALL, pause all tokens
     if (token_contract == name() || token_symbol.code().to_string() == "ALL" || token_symbol.code().raw() == 0) {
-        auto config_itr = config_tbl.begin();
-        while(config_itr != config_tbl.end()) {
-            config_tbl.modify(config_itr, get_self(), [&](auto& row) {
-                row.is_paused = should_pause;
-            });
-            config_itr++;
+        for (const auto& row : _configs.table()) {
+            close_epoch(row.token_symbol.code());
+            _configs.modify(row.primary_key(), get_self()).is_paused = should_pause;
         }
         return;
     }
 
     // Find and update specific token configuration
-    auto config_itr = config_tbl.find(token_symbol.code().raw());
-    check(config_itr != config_tbl.end(), "🔯 Token configuration not found");
+    const config* config_itr = _configs.find(token_symbol.code().raw());
+    check(config_itr != nullptr, "🔯 Token configuration not found");
     check(config_itr->token_contract == token_contract, 
           "🔯 Token contract does not match configuration");
 
-    config_tbl.modify(config_itr, get_self(), [&](auto& row) {
-        row.is_paused = should_pause;
-    });
+    // Paused time earns nothing
+    close_epoch(token_symbol.code());
+    _configs.modify(token_symbol.code().raw(), get_self()).is_paused = should_pause;
 }
 
-void stakepurple::process_claim(const name& user, bool reset_unstake_period) {
-    stake_t stake_tbl(get_self(), user.value);
+void stakepurple::set_allowed(const name& token_contract, const symbol_code& token_code, bool allowed) {
+    counted_t<allowlist_t> allowlist(get_self(), get_self().value);
+    auto itr = allowlist.find(token_contract.value);
+
+    if (allowed) {
+        if (itr == allowlist.end()) {
+            allowlist.emplace(get_self(), [&](auto& row) {
+                row.contract = token_contract;
+                row.symbols.push_back(token_code);
+            });
+        } else if (std::find(itr->symbols.begin(), itr->symbols.end(), token_code) == itr->symbols.end()) {
+            allowlist.modify(itr, get_self(), [&](auto& row) { row.symbols.push_back(token_code); });
+        }
+        return;
+    }
+
+    if (itr == allowlist.end()) return;
+    if (itr->symbols.size() == 1 && itr->symbols.front() == token_code) {
+        allowlist.erase(itr);
+    } else {
+        allowlist.modify(itr, get_self(), [&](auto& row) {
+            row.symbols.erase(std::remove(row.symbols.begin(), row.symbols.end(), token_code), row.symbols.end());
+        });
+    }
+}
+
+void stakepurple::process_claim(const name& user, bool reset_unstake_period, bool pay_out) {
+    auto& stakes = stakes_of(user);
+    std::vector<uint64_t> keys = stakes.keys();
     // We need to check all staked tokens for this user
-    check(stake_tbl.begin() != stake_tbl.end(), "🔯 No staked tokens found.");
+    check(!keys.empty(), "🔯 No staked tokens found.");
+    // Stakers from before the registry join it on their first claim or top-up
+    register_staker(user);
 
-    config_t config_tbl(get_self(), get_self().value);
-    
-    // Check if any of user's staked tokens are paused
-    for(auto stake_itr = stake_tbl.begin(); stake_itr != stake_tbl.end(); stake_itr++) {
-        auto config_itr = config_tbl.find(stake_itr->staked_amount.symbol.code().raw());
-        check(config_itr != config_tbl.end(), "🔯 Token configuration not found.");
+    // Rewards summed per reward token, sent once each after the pass, in stake order
+    struct payout {
+        name reward_token_contract;
+        asset reward;
+        uint8_t memo_mode;     // Most verbose mode among the stakes paid
+        claim_receipt first;   // Breakdown of the first stake, for the full memo
+        uint32_t stakes = 1;
+        std::string staked_codes; // Filled once a second stake is folded in
+    };
+    std::vector<payout> payouts;
+
+    // Breakdown of every stake and the payout it went into; those the memo leaves out are published by logclaim
+    struct stake_paid {
+        size_t payout;
+        uint8_t memo_mode;
+        claim_receipt receipt;
+    };
+    std::vector<stake_paid> paid;
+
+    // Process each staked token in a single pass; a paused token aborts the whole claim
+    for (uint64_t pk : keys) {
+        const stake_s* stake_itr = stakes.find(pk);
+        const config* config_itr = _configs.find(stake_itr->staked_amount.symbol.code().raw());
+        check(config_itr != nullptr, "🔯 Token configuration not found.");
         check(!config_itr->is_paused, "🔯 Claims are paused for " + stake_itr->staked_amount.symbol.code().to_string() + 
               " unstake your " + stake_itr->staked_amount.symbol.code().to_string() + " then claim.");
-    }
-
-    // Process each staked token
-    for(auto stake_itr = stake_tbl.begin(); stake_itr != stake_tbl.end(); stake_itr++) {
-        auto config_itr = config_tbl.find(stake_itr->staked_amount.symbol.code().raw());
-        check(config_itr != config_tbl.end(), "🔯 Token configuration not found.");
-        if (config_itr->is_paused) {
-            continue;
-        }
 
         // New check for minimum time between claims
         uint32_t time_since_last_claim = current_time_point().sec_since_epoch() - stake_itr->last_claim.sec_since_epoch();
         //check(time_since_last_claim >= 43200, "🔯 You must wait at least 12 hours between claims."); // FLAG CHANGE THIS BACK TO 12 HOURS
-        check(time_since_last_claim >= 200, "🔯 Douglas, you must change this back."); // FLAG CHANGE THIS BACK TO 12 HOURS
-        // Calculate the user's level based on the Tetrahedral series
-        uint64_t staked_amount = floor(stake_itr->staked_amount.amount / pow(10, stake_itr->staked_amount.symbol.precision()));
-         //check(false, to_string(staked_amount) + " .. " + to_string(pow(10, stake_itr->staked_amount.symbol.precision())) + " .. " + to_string(stake_itr->staked_amount.amount) + " 🔯.");
-        //staked_amount
-        size_t level = 0;
-        for (size_t i = 0; i < TETRAHEDRAL.size(); ++i) {
-            if (staked_amount < TETRAHEDRAL[i]) {
-                level = i;
-                break;
+        check(time_since_last_claim >= MIN_CLAIM_INTERVAL, "🔯 Douglas, you must change this back."); // FLAG CHANGE THIS BACK TO 12 HOURS
+
+        reward_index index = index_of(stake_itr->staked_amount.symbol.code());
+        claim_receipt receipt = receipt_of(*stake_itr, *config_itr, index);
+        asset reward = receipt.reward;
+
+        // Counted once settled, whether it is transferred now or credited
+        stats_of(stake_itr->staked_amount.symbol.code()).rewards_paid += reward.amount;
+
+        // Rewards are settled up to now, whether or not the unstake period restarts
+        auto& settled = stakes.modify(stake_itr->primary_key(), get_self());
+        settled.checkpoint.emplace(stake_checkpoint{index.rate_seconds, index.active_seconds});
+        if (reset_unstake_period) {
+            // Update last_claim time only if reset is desired
+            settled.last_claim = time_point_sec(current_time_point());
+        }
+
+        uint8_t mode = config_itr->memo_mode.value_or(MEMO_FULL);
+
+        // Fold into an earlier stake paying the same reward token
+        auto same_token = std::find_if(payouts.begin(), payouts.end(), [&](const payout& p) {
+            return p.reward_token_contract == config_itr->reward_token_contract && p.reward.symbol == reward.symbol;
+        });
+        paid.push_back({static_cast<size_t>(same_token - payouts.begin()), mode, receipt});
+        if (same_token != payouts.end()) {
+            if (same_token->stakes == 1) {
+                same_token->staked_codes = same_token->first.staked_symbol.code().to_string();
             }
+            same_token->reward += reward;
+            same_token->memo_mode = std::min(same_token->memo_mode, mode);
+            same_token->stakes++;
+            same_token->staked_codes += ", " + receipt.staked_symbol.code().to_string();
+            continue;
         }
 
-        // Calculate amount needed for next level
-        uint64_t next_level_amount = TETRAHEDRAL[level] - staked_amount;
+        payouts.push_back({config_itr->reward_token_contract, reward, mode, receipt});
+    }
 
-        // Determine the reward rate using the Triangular series
-        uint32_t lvl = TRIANGULAR[level];
-        uint32_t reward_rate = config_itr->reward_rate + level; // EXPLAIN reward_rate should be the # of reward tokens per day * 100
+    // Compact and empty memos leave the breakdown out, and so does the full memo of a combined payout
+    std::vector<claim_receipt> receipts;
+    for (const auto& stake : paid) {
+        if (stake.memo_mode != MEMO_FULL || payouts[stake.payout].stakes > 1) {
+            receipts.push_back(stake.receipt);
+        }
+    }
 
-        // Calculate 1 BLUX per day reward
-        uint32_t days_passed = (current_time_point().sec_since_epoch() - stake_itr->last_claim.sec_since_epoch()) / (24 * 3600);
-        asset reward = asset(static_cast<int64_t>(staked_amount * (reward_rate / 100) * days_passed), config_itr->reward_token_symbol);
-        // Add bonus to user level
-        reward += asset(lvl, config_itr->reward_token_symbol);
+    // Top-ups and unstakes only credit the ledger, keeping token transfers off those paths
+    if (!pay_out) {
+        for (const auto& p : payouts) {
+            credit_reward(user, p.reward_token_contract, p.reward);
+        }
+        payouts.clear();
+    } else {
+        // Credited rewards ride along with this claim's transfer of the same token
+        counted_t<rewards_t> ledger(get_self(), user.value);
+        auto by_token = ledger.get_index<"bytoken"_n>();
+        for (auto& p : payouts) {
+            auto owed = by_token.find(reward_balance::token_key(p.reward_token_contract, p.reward.symbol));
+            if (owed != by_token.end()) {
+                _changes.append(changelog::REWARD, user, owed->id);
+                p.reward += owed->balance;
+                ledger.erase(*owed);
+            }
+        }
+    }
 
-        if (reset_unstake_period) {
-            // Update last_claim time only if reset is desired
-            stake_tbl.modify(stake_itr, get_self(), [&](auto& row) {
-                row.last_claim = time_point_sec(current_time_point());
-            });
+    // Send rewards to user, one transfer per reward token
+    for (const auto& p : payouts) {
+        std::string memo;
+        if (p.memo_mode == MEMO_COMPACT) {
+            memo = "🔯 PURPLE 🔷 Rewards 🍄";
+        } else if (p.memo_mode == MEMO_FULL && p.stakes > 1) {
+            memo = "🔯 PURPLE 🔷 Rewards for " + p.staked_codes + " 🍄";
+        } else if (p.memo_mode == MEMO_FULL) {
+            const claim_receipt& r = p.first;
+            uint32_t hours_passed = r.elapsed_seconds / 3600;
+            uint32_t minutes_passed = (r.elapsed_seconds % 3600) / 60;
+            memo = "🔯 PURPLE 🔷 Rewards: ⏳ " + to_string(r.days_passed) + " days, " + to_string(hours_passed) + " hours, " + to_string(minutes_passed) + "m | ";
+            memo += "🔒: "+to_string(r.staked_amount) +"🔯 @ " + to_string(r.reward_rate) + "% | Bonus: " + to_string(r.bonus) + " 🔷 | Next Level: +" + to_string(r.next_level) + " PURPLE staked 🍄";
         }
 
-        uint32_t hours_passed = time_since_last_claim / 3600;
-        uint32_t minutes_passed = (time_since_last_claim % 3600) / 60;
-        std::string memo = "🔯 PURPLE 🔷 Rewards: ⏳ " + to_string(days_passed) + " days, " + to_string(hours_passed) + " hours, " + to_string(minutes_passed) + "m | ";
-        memo += "🔒: "+to_string(staked_amount) +"🔯 @ " + to_string(reward_rate) + "% | Bonus: " + to_string(lvl) + " 🔷 | Next Level: +" + to_string(next_level_amount) + " PURPLE staked 🍄";
+        action(
+            permission_level{get_self(), name("active")},
+            p.reward_token_contract,
+            name("transfer"),
+            std::make_tuple(get_self(), user, p.reward, memo)
+        ).send();
+        instrumentation::inline_sent();
+    }
 
-        // Send rewards to user
+    // Credited rewards in tokens this claim did not pay
+    if (pay_out) {
+        pay_rewards(user);
+    }
 
-        //check(false, memo);
+    // Typed breakdown for indexers, one action for the whole claim
+    if (!receipts.empty()) {
         action(
             permission_level{get_self(), name("active")},
-            config_itr->reward_token_contract,
+            get_self(),
+            name("logclaim"),
+            std::make_tuple(user, receipts)
+        ).send();
+        instrumentation::inline_sent();
+    }
+}
+bool stakepurple::can_claim(const name& user) {
+    auto& stakes = stakes_of(user);
+    std::vector<uint64_t> keys = stakes.keys();
+    if (keys.empty()) {
+        return false;
+    }
+
+    // Same conditions process_claim checks, so a batch skips instead of failing
+    uint32_t now = current_time_point().sec_since_epoch();
+    for (uint64_t pk : keys) {
+        const stake_s* stake_itr = stakes.find(pk);
+        const config* config_itr = _configs.find(stake_itr->staked_amount.symbol.code().raw());
+        if (config_itr == nullptr || config_itr->is_paused || now - stake_itr->last_claim.sec_since_epoch() < MIN_CLAIM_INTERVAL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void stakepurple::credit_reward(const name& user, const name& token_contract, const asset& reward) {
+    if (reward.amount == 0) return;
+
+    counted_t<rewards_t> ledger(get_self(), user.value);
+    auto by_token = ledger.get_index<"bytoken"_n>();
+    auto owed = by_token.find(reward_balance::token_key(token_contract, reward.symbol));
+    if (owed == by_token.end()) {
+        uint64_t id = ledger.available_primary_key();
+        _changes.append(changelog::REWARD, user, id);
+        ledger.emplace(get_self(), [&](auto& row) {
+            row.id = id;
+            row.token_contract = token_contract;
+            row.balance = reward;
+        });
+        return;
+    }
+
+    _changes.append(changelog::REWARD, user, owed->id);
+    ledger.modify(*owed, get_self(), [&](auto& row) { row.balance += reward; });
+}
+
+uint32_t stakepurple::pay_rewards(const name& user) {
+    counted_t<rewards_t> ledger(get_self(), user.value);
+    uint32_t sent = 0;
+    for (auto itr = ledger.begin(); itr != ledger.end(); itr = ledger.erase(itr)) {
+        _changes.append(changelog::REWARD, user, itr->id);
+        action(
+            permission_level{get_self(), name("active")},
+            itr->token_contract,
             name("transfer"),
-            std::make_tuple(get_self(), user, reward, memo)
+            std::make_tuple(get_self(), user, itr->balance, std::string("🔯 PURPLE 🔷 Rewards 🍄"))
         ).send();
+        instrumentation::inline_sent();
+        sent++;
     }
-}
\ No newline at end of file
+    return sent;
+}
+
+void stakepurple::register_staker(const name& user) {
+    if (_stakers.find(user.value) != nullptr) return;
+    _stakers.emplace(get_self(), staker{user});
+
+    // countstakes will not reach a staker that joins behind its cursor, so its stakes are added now
+    if (is_counted(user)) count_staker(user);
+}
+
+uint32_t stakepurple::count_staker(const name& user) {
+    auto& stakes = stakes_of(user);
+    uint32_t counted = 0;
+    for (uint64_t pk : stakes.keys()) {
+        const stake_s* stake_itr = stakes.find(pk);
+        if (stake_itr == nullptr) continue;
+        token_stats& stats = stats_of(stake_itr->staked_amount.symbol.code());
+        stats.total_staked += stake_itr->staked_amount.amount;
+        stats.stakers++;
+        counted++;
+    }
+    return counted;
+}
+
+bool stakepurple::is_counted(const name& user) {
+    if (!_count.has_value()) {
+        counted_t<count_t> progress(get_self(), get_self().value);
+        _count = progress.get_or_default();
+    }
+    return _count->done || user.value < _count->cursor.value;
+}
+
+void stakepurple::count_stake(const name& user, const asset& delta, int64_t stakers_delta) {
+    // Stakers ahead of the cursor are added whole when countstakes reaches them
+    if (!is_counted(user)) return;
+
+    token_stats& stats = stats_of(delta.symbol.code());
+    stats.total_staked += delta.amount;
+    stats.stakers += stakers_delta;
+}
+
+stakepurple::token_stats& stakepurple::stats_of(const symbol_code& token_code) {
+    if (_stats.find(token_code.raw()) == nullptr) {
+        token_stats row;
+        row.token_code = token_code;
+        return _stats.emplace(get_self(), row);
+    }
+    return _stats.modify(token_code.raw(), get_self());
+}
+
+stakepurple::reward_index stakepurple::index_of(const symbol_code& token_code) {
+    const config* config_itr = _configs.find(token_code.raw());
+    check(config_itr != nullptr, "🔯 Token configuration not found.");
+
+    // Tokens configured before the index start accruing from their first use, which stores the start
+    reward_index index = current_index(*config_itr);
+    if (config_itr->index.value_or().updated.sec_since_epoch() == 0) {
+        _configs.modify(token_code.raw(), get_self()).index.emplace(index);
+    }
+    return index;
+}
+
+stakepurple::reward_index stakepurple::current_index(const config& token_config) const {
+    time_point_sec now = time_point_sec(current_time_point());
+
+    // The marker is `updated`, not the extension: any other write to a config
+    // from before the index stores a zero index
+    reward_index index = token_config.index.value_or();
+    if (index.updated.sec_since_epoch() == 0) return reward_index{0, 0, now};
+
+    // Add the open epoch; the rate and pause state are constant since `updated`
+    if (!token_config.is_paused) {
+        uint64_t elapsed = now.sec_since_epoch() - index.updated.sec_since_epoch();
+        index.rate_seconds += elapsed * token_config.reward_rate;
+        index.active_seconds += elapsed;
+    }
+    index.updated = now;
+    return index;
+}
+
+stakepurple::stake_checkpoint stakepurple::checkpoint_of(const stake_s& row, const config& token_config, const reward_index& index) const {
+    if (row.checkpoint.has_value()) return row.checkpoint.value();
+
+    // Whole days since last_claim, as rate x seconds and seconds behind the index
+    uint64_t seconds = uint64_t((index.updated.sec_since_epoch() - row.last_claim.sec_since_epoch()) / (24 * 3600)) * (24 * 3600);
+    return stake_checkpoint{index.rate_seconds - seconds * token_config.reward_rate, index.active_seconds - seconds};
+}
+
+stakepurple::claim_receipt stakepurple::receipt_of(const stake_s& row, const config& token_config, const reward_index& index) const {
+    uint32_t time_since_last_claim = index.updated.sec_since_epoch() - row.last_claim.sec_since_epoch();
+
+    // Calculate the user's level based on the Tetrahedral series (whole tokens, rounded down)
+    std::optional<fixed_point::uint128> whole = fixed_point::to_whole(row.staked_amount.amount, row.staked_amount.symbol.precision());
+    check(whole.has_value(), "🔯 Invalid token precision.");
+    uint64_t staked_amount = static_cast<uint64_t>(*whole);
+    size_t level = figurate::level(TETRAHEDRAL, staked_amount);
+
+    // Calculate amount needed for next level (none past the top level)
+    uint64_t next_level_amount = level < TETRAHEDRAL.size() ? TETRAHEDRAL[level] - staked_amount : 0;
+
+    // Determine the reward rate using the Triangular series
+    uint32_t lvl = TRIANGULAR[level];
+    uint32_t reward_rate = token_config.reward_rate + level; // EXPLAIN reward_rate should be the # of reward tokens per day * 100
+
+    // Calculate 1 BLUX per day reward
+    uint32_t days_passed = time_since_last_claim / (24 * 3600);
+
+    // Settle against the index: (reward_rate + level) / 100 tokens per staked token per day,
+    // at whatever rate was in force over each epoch since the checkpoint; a stake from before
+    // the index is paid its whole days at the current rate
+    stake_checkpoint checkpoint = checkpoint_of(row, token_config, index);
+    fixed_point::uint128 rate_seconds = fixed_point::uint128(index.rate_seconds - checkpoint.rate_seconds)
+        + fixed_point::uint128(level) * (index.active_seconds - checkpoint.active_seconds);
+    std::optional<int64_t> units = fixed_point::to_amount(fixed_point::mul_div(staked_amount, rate_seconds, 100 * 24 * 3600));
+    check(units.has_value(), "🔯 Reward overflow.");
+    asset reward = asset(*units, token_config.reward_token_symbol);
+    // Add bonus to user level
+    reward += asset(lvl, token_config.reward_token_symbol);
+
+    return claim_receipt{row.staked_amount.symbol, reward, time_since_last_claim, days_passed, staked_amount, reward_rate, lvl, next_level_amount};
+}
+
+void stakepurple::close_epoch(const symbol_code& token_code) {
+    reward_index index = index_of(token_code);
+    _configs.modify(token_code.raw(), get_self()).index.emplace(index);
+}
+
+std::optional<uint64_t> stakepurple::symbol_slots::find(const symbol_code& code) {
+    load();
+    for (uint64_t slot = 0; slot < _symbols.size(); slot++) {
+        if (_symbols[slot].code() == code) return slot;
+    }
+    return std::nullopt;
+}
+
+uint64_t stakepurple::symbol_slots::intern(const symbol& sym) {
+    std::optional<uint64_t> existing = find(sym.code());
+    if (existing.has_value()) return *existing;
+
+    // Slots are stored in one byte on compact stakes
+    check(_symbols.size() <= UINT8_MAX, "🔯 No symbol slots left.");
+    uint64_t slot = _symbols.size();
+    _table.emplace(_code, [&](auto& row) {
+        row.slot = slot;
+        row.sym = sym;
+    });
+    _symbols.push_back(sym);
+    return slot;
+}
+
+const symbol& stakepurple::symbol_slots::get(uint64_t slot) {
+    load();
+    check(slot < _symbols.size(), "🔯 Unknown symbol slot.");
+    return _symbols[slot];
+}
+
+void stakepurple::symbol_slots::load() {
+    if (_loaded) return;
+    // Slots are handed out in order from 0, so the rows come back in slot order
+    for (const auto& row : _table) {
+        _symbols.push_back(row.sym);
+    }
+    _loaded = true;
+}
+
+stakepurple::stake_v2 stakepurple::stake_codec::pack(const stake_s& row) const {
+    // Claims before the epoch are long past any interval or lock, so they are stored as the epoch
+    uint32_t last_claim = std::max(row.last_claim.sec_since_epoch(), CONTRACT_EPOCH) - CONTRACT_EPOCH;
+
+    stake_v2 packed;
+    packed.slot = slots->intern(row.staked_amount.symbol);
+    packed.amount = row.staked_amount.amount;
+    packed.last_claim = last_claim;
+    packed.checkpoint = row.checkpoint.value();
+    return packed;
+}
+
+stakepurple::stake_s stakepurple::stake_codec::unpack(const stake_v2& row) const {
+    stake_s unpacked;
+    unpacked.staked_amount = asset(row.amount, slots->get(row.slot));
+    unpacked.last_claim = time_point_sec(CONTRACT_EPOCH + row.last_claim);
+    unpacked.checkpoint.emplace(row.checkpoint);
+    return unpacked;
+}
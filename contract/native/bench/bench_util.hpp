@@ -0,0 +1,50 @@
+#pragma once
+#include "../tests/test_util.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <eosio/eosio.hpp>
+
+// === Benchmark Helpers === //
+// --- Account names, size limits and per-action database counters --- //
+
+namespace bench {
+
+  using namespace eosio;
+
+  // - Same names as the tests
+  using test::account;
+
+  // - Largest size a benchmark family runs at, overridable from the environment
+  inline int64_t max_size(const char* env, int64_t fallback) {
+    const char* value = std::getenv(env);
+    return value != nullptr ? std::atoll(value) : fallback;
+  }
+
+  // - Powers of `step` from `first` up to the limit in `env`
+  inline void sizes(benchmark::internal::Benchmark* b, const char* env, int64_t fallback, int64_t first, int64_t step) {
+    for (int64_t n = first; n <= max_size(env, fallback); n *= step) b->Arg(n);
+  }
+
+  // - Database operations and inline actions issued since construction, reported per iteration
+  class action_cost {
+  public:
+    action_cost() : _db(mock::state().db), _actions(mock::state().actions.size()) {}
+
+    void report(benchmark::State& state) const {
+      const auto& db = mock::state().db;
+      auto per_action = [&](uint64_t now, uint64_t before) {
+        return benchmark::Counter(double(now - before), benchmark::Counter::kAvgIterations);
+      };
+      state.counters["db_ops"] = per_action(db.total(), _db.total());
+      state.counters["finds"] = per_action(db.finds + db.nexts, _db.finds + _db.nexts);
+      state.counters["writes"] = per_action(db.emplaces + db.modifies + db.erases, _db.emplaces + _db.modifies + _db.erases);
+      state.counters["sec_updates"] = per_action(db.secondary_updates, _db.secondary_updates);
+      state.counters["inline"] = per_action(mock::state().actions.size(), _actions);
+    }
+
+  private:
+    mock::db_counters _db;
+    size_t            _actions;
+  };
+
+}
@@ -0,0 +1,206 @@
+#include "bench_util.hpp"
+#include "invitono.hpp"
+
+// === invitono Benchmarks === //
+// --- Registration, crank and claim cost as the referral tree gets deeper and wider --- //
+
+using namespace eosio;
+using bench::account;
+
+namespace {
+
+  const name SELF = "invitono"_n;
+  const name TOKEN = "eosio.token"_n;
+
+  // - Fresh contract with the root adopter seeded; no age limit and, by default, no cooldown, so every level is credited
+  void setup(uint16_t max_depth, uint32_t invite_rate = 0) {
+    mock::reset();
+    mock::create_account(SELF);
+    mock::create_account(TOKEN);
+    mock::create_account(account(0));
+
+    mock::apply<invitono>(SELF, SELF, {SELF}, [&](invitono& c) {
+      c.setconfig(SELF, 0, invite_rate, true, max_depth, 100, TOKEN, symbol("INV", 4), 100);
+    });
+
+    // - The root has no inviter, so it is seeded directly
+    invitono::adopters_table adopters(SELF, SELF.value);
+    adopters.emplace(SELF, [&](auto& row) { row.account = account(0); });
+  }
+
+  // - From here on registrations only queue their credit
+  void set_lazy() {
+    mock::apply<invitono>(SELF, SELF, {SELF}, [&](invitono& c) { c.setmode(true, 0); });
+  }
+
+  void register_user(name user, name inviter) {
+    mock::create_account(user);
+    mock::apply<invitono>(SELF, SELF, {user}, [&](invitono& c) { c.registeruser(user, inviter); });
+  }
+
+  // - Adopters 1..count-1, each invited by (i - 1) / fanout, so the tree is complete and log_fanout(count) deep
+  void build_tree(uint64_t count, uint64_t fanout) {
+    for (uint64_t i = 1; i < count; i++) register_user(account(i), account((i - 1) / fanout));
+  }
+
+  // - Adopters 1..depth in a single line under the root
+  void build_chain(uint64_t depth) {
+    for (uint64_t i = 1; i <= depth; i++) register_user(account(i), account(i - 1));
+  }
+
+  void depths(benchmark::internal::Benchmark* b) {
+    for (int64_t depth : {1, 10, 25, 50, 100}) b->Arg(depth);
+  }
+
+  void trees(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"adopters", "fanout"});
+    for (int64_t fanout : {2, 8, 64}) {
+      for (int64_t n = 1000; n <= bench::max_size("BENCH_MAX_ADOPTERS", 100000); n *= 10) b->Args({n, fanout});
+    }
+  }
+
+}
+
+// - Registration under the bottom of a chain: one credit per level, max_referral_depth = 100
+static void BM_RegisterDepth(benchmark::State& state) {
+  uint64_t depth = state.range(0);
+  setup(100);
+  build_chain(depth);
+
+  uint64_t next = depth + 1;
+  bench::action_cost cost;
+  for (auto _ : state) {
+    register_user(account(next++), account(depth));
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_RegisterDepth)->Apply(depths)->ArgName("depth")->Iterations(1000);
+
+// - Same chain with every ancestor in a day-long cooldown: no score moves, but each level's counts
+//   are still written: writes match BM_RegisterDepth, one ancestor row per level
+static void BM_RegisterCooldown(benchmark::State& state) {
+  uint64_t depth = state.range(0);
+  setup(100, 24 * 3600);
+  build_chain(depth);
+
+  uint64_t next = depth + 1;
+  bench::action_cost cost;
+  for (auto _ : state) {
+    register_user(account(next++), account(depth));
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_RegisterCooldown)->Apply(depths)->ArgName("depth")->Iterations(1000);
+
+// - Registration under the deepest leaf of a complete tree
+static void BM_RegisterFanout(benchmark::State& state) {
+  uint64_t count = state.range(0);
+  setup(100);
+  build_tree(count, state.range(1));
+
+  uint64_t next = count;
+  bench::action_cost cost;
+  for (auto _ : state) {
+    register_user(account(next++), account(count - 1));
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_RegisterFanout)->Apply(trees)->Iterations(1000);
+
+// - Lazy registration queues one credit row and rewrites no ancestor, whatever the depth
+static void BM_RegisterLazy(benchmark::State& state) {
+  uint64_t depth = state.range(0);
+  setup(100);
+  build_chain(depth);
+  set_lazy();
+
+  uint64_t next = depth + 1;
+  bench::action_cost cost;
+  for (auto _ : state) {
+    register_user(account(next++), account(depth));
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_RegisterLazy)->Apply(depths)->ArgName("depth")->Iterations(1000);
+
+// - One queued credit applied per crank, each walking `depth` levels
+static void BM_Crank(benchmark::State& state) {
+  uint64_t depth = state.range(0);
+  setup(100);
+  build_chain(depth);
+  set_lazy();
+  for (int64_t i = 0; i < state.max_iterations; i++) register_user(account(depth + 1 + i), account(depth));
+
+  bench::action_cost cost;
+  for (auto _ : state) {
+    mock::apply<invitono>(SELF, SELF, {SELF}, [](invitono& c) { c.crank(1); });
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_Crank)->Apply(depths)->ArgName("depth")->Iterations(1000);
+
+// - Claim by successive adopters of a complete 4-ary tree with nothing queued
+static void BM_ClaimReward(benchmark::State& state) {
+  uint64_t count = state.range(0);
+  setup(100);
+  build_tree(count, 4);
+
+  uint64_t next = 1;
+  bench::action_cost cost;
+  for (auto _ : state) {
+    name user = account(next++);
+    mock::apply<invitono>(SELF, SELF, {user}, [&](invitono& c) { c.claimreward(user); });
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_ClaimReward)
+  ->Apply([](benchmark::internal::Benchmark* b) { bench::sizes(b, "BENCH_MAX_ADOPTERS", 100000, 1000, 10); })
+  ->ArgName("adopters")
+  ->Iterations(999);
+
+// - One claim while `queued` credits are pending: a few are applied inline and the rest, up to
+//   the read limit of 25, replayed a walk each
+static void BM_ClaimRewardPending(benchmark::State& state) {
+  uint64_t queued = state.range(0);
+  setup(100);
+  build_tree(1000, 4);
+  set_lazy();
+  for (uint64_t i = 0; i < queued; i++) register_user(account(1000 + i), account(999 - i % 500));
+
+  uint64_t next = 1;
+  bench::action_cost cost;
+  for (auto _ : state) {
+    name user = account(next++);
+    mock::apply<invitono>(SELF, SELF, {user}, [&](invitono& c) { c.claimreward(user); });
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_ClaimRewardPending)->Arg(0)->Arg(10)->Arg(30)->ArgName("queued")->Iterations(1);
+
+// - One refreshlb chunk of 100 rows, cycling through clear, refill and swap over the whole table
+static void BM_RefreshLeaderboard(benchmark::State& state) {
+  uint64_t count = state.range(0);
+  setup(100);
+  build_tree(count, 4);
+
+  bench::action_cost cost;
+  for (auto _ : state) {
+    mock::apply<invitono>(SELF, SELF, {}, [&](invitono& c) { c.refreshlb(100); });
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_RefreshLeaderboard)
+  ->Apply([](benchmark::internal::Benchmark* b) { bench::sizes(b, "BENCH_MAX_ADOPTERS", 100000, 1000, 10); })
+  ->ArgName("adopters")
+  ->Iterations(1000);
+
+// - Reward position lookup for scores across the whole series
+static void BM_TetrahedralPosition(benchmark::State& state) {
+  constexpr auto series = figurate::tetrahedral_series<24>();
+  uint64_t score = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(figurate::level(series, score));
+    score = (score + 7) % 3000;
+  }
+}
+BENCHMARK(BM_TetrahedralPosition);
@@ -0,0 +1,151 @@
+#include "bench_util.hpp"
+#include "stakepurple.hpp"
+
+// === stakepurple Benchmarks === //
+// --- Claim, top-up, unstake and batch claim cost as stakes per user and stakers grow --- //
+
+using namespace eosio;
+using bench::account;
+
+namespace {
+
+  const name SELF = "stakepurple"_n;
+  const name TOKEN = "token"_n;
+  const symbol REWARD = symbol("RWD", 4);
+
+  // - Staked token i, all paying REWARD
+  symbol staked_symbol(uint64_t i) {
+    return symbol(std::string("STK") + char('A' + i % 26) + char('A' + i / 26), 4);
+  }
+
+  // - Fresh contract with `tokens` stakeable tokens, unstakeable after one second
+  void setup(uint64_t tokens) {
+    mock::reset();
+    mock::create_account(SELF);
+    mock::create_account(TOKEN);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) {
+      for (uint64_t i = 0; i < tokens; i++) c.setparams(SELF, staked_symbol(i), TOKEN, REWARD, TOKEN, 1, 100);
+    });
+  }
+
+  void stake(name user, const asset& quantity) {
+    mock::create_account(user);
+    mock::apply<stakepurple>(SELF, TOKEN, {TOKEN}, [&](stakepurple& c) { c.on_transfer(user, SELF, quantity, ""); });
+  }
+
+  // - 1000 tokens of each of the first `tokens` symbols
+  void stake_all(name user, uint64_t tokens) {
+    for (uint64_t i = 0; i < tokens; i++) stake(user, asset(1000'0000, staked_symbol(i)));
+  }
+
+  void stakes(benchmark::internal::Benchmark* b) {
+    for (int64_t tokens : {1, 4, 16}) b->Arg(tokens);
+    b->ArgName("stakes");
+  }
+
+}
+
+// - Incoming transfers that are not stakes: another contract's token, and an unconfigured symbol of the staked contract;
+//   each is one allowlist lookup, without writes
+static void BM_TransferReject(benchmark::State& state) {
+  setup(16);
+  name spammer = "spam.token"_n;
+  mock::create_account(spammer);
+  name first_receiver = state.range(0) == 0 ? spammer : TOKEN;
+  asset airdrop = state.range(0) == 0 ? asset(1'0000, staked_symbol(0)) : asset(1'0000, symbol("DROP", 4));
+
+  bench::action_cost cost;
+  for (auto _ : state) {
+    mock::apply<stakepurple>(SELF, first_receiver, {first_receiver}, [&](stakepurple& c) {
+      c.on_transfer(spammer, SELF, airdrop, "for: someone");
+    });
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_TransferReject)->Arg(0)->Arg(1)->ArgName("known_contract");
+
+// - Claim by one user holding `stakes` stakes
+static void BM_Claim(benchmark::State& state) {
+  uint64_t tokens = state.range(0);
+  setup(tokens);
+  name user = account(0);
+  stake_all(user, tokens);
+
+  bench::action_cost cost;
+  for (auto _ : state) {
+    mock::add_time(MIN_CLAIM_INTERVAL);
+    mock::apply<stakepurple>(SELF, SELF, {user}, [&](stakepurple& c) { c.claim(user); });
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_Claim)->Apply(stakes);
+
+// - Top-up transfer, which settles every stake of the user into the reward ledger first
+static void BM_TopUp(benchmark::State& state) {
+  uint64_t tokens = state.range(0);
+  setup(tokens);
+  name user = account(0);
+  stake_all(user, tokens);
+  mock::add_time(MIN_CLAIM_INTERVAL);
+
+  bench::action_cost cost;
+  for (auto _ : state) {
+    stake(user, asset(10'0000, staked_symbol(0)));
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_TopUp)->Apply(stakes);
+
+// - Partial unstake, which also settles every stake of the user into the reward ledger
+static void BM_Unstake(benchmark::State& state) {
+  uint64_t tokens = state.range(0);
+  setup(tokens);
+  name user = account(0);
+  stake_all(user, tokens);
+  mock::add_time(MIN_CLAIM_INTERVAL);
+
+  bench::action_cost cost;
+  for (auto _ : state) {
+    mock::apply<stakepurple>(SELF, SELF, {user}, [&](stakepurple& c) { c.unstake(user, asset(1, staked_symbol(0))); });
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_Unstake)->Apply(stakes);
+
+// - Withdraw of the rewards one top-up credited: one transfer, as every stake pays REWARD;
+//   time is the withdraw alone, the counters include the top-up
+static void BM_Withdraw(benchmark::State& state) {
+  uint64_t tokens = state.range(0);
+  setup(tokens);
+  name user = account(0);
+  stake_all(user, tokens);
+
+  bench::action_cost cost;
+  for (auto _ : state) {
+    state.PauseTiming();
+    mock::add_time(MIN_CLAIM_INTERVAL);
+    stake(user, asset(10'0000, staked_symbol(0)));
+    state.ResumeTiming();
+    mock::apply<stakepurple>(SELF, SELF, {user}, [&](stakepurple& c) { c.withdraw(user); });
+  }
+  cost.report(state);
+}
+BENCHMARK(BM_Withdraw)->Apply(stakes);
+
+// - One claimbatch over every staker, each holding one stake
+static void BM_ClaimBatch(benchmark::State& state) {
+  uint64_t stakers = state.range(0);
+  setup(1);
+  for (uint64_t i = 0; i < stakers; i++) stake(account(i), asset(1000'0000, staked_symbol(0)));
+
+  bench::action_cost cost;
+  for (auto _ : state) {
+    mock::add_time(MIN_CLAIM_INTERVAL);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.claimbatch(name(), stakers); });
+  }
+  cost.report(state);
+  state.SetItemsProcessed(state.iterations() * stakers);
+}
+BENCHMARK(BM_ClaimBatch)
+  ->Apply([](benchmark::internal::Benchmark* b) { bench::sizes(b, "BENCH_MAX_STAKERS", 10000, 10, 10); })
+  ->ArgName("stakers");
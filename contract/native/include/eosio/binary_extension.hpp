@@ -0,0 +1,72 @@
+#pragma once
+#include <optional>
+#include <utility>
+#include "eosio.hpp"
+
+// === Host-Native eosio::binary_extension === //
+// --- Optional trailing field; on the host it is a std::optional with eosio's accessors. --- //
+// --- Copied into a table it is stored as the chain stores it: value_or(), so unset --- //
+// --- only lasts on rows that were never written with the field --- //
+
+namespace eosio {
+
+  template <typename T>
+  class binary_extension {
+  public:
+    binary_extension() = default;
+    binary_extension(const T& ext) : _value(ext) {}
+    binary_extension(T&& ext) : _value(std::move(ext)) {}
+
+    binary_extension(const binary_extension& other) {
+      if (other._value.has_value()) _value.emplace(*other._value);
+      store();
+    }
+
+    binary_extension(binary_extension&& other) {
+      if (other._value.has_value()) _value.emplace(std::move(*other._value));
+      store();
+    }
+
+    binary_extension& operator=(const binary_extension&) = default;
+    binary_extension& operator=(binary_extension&&) = default;
+
+    bool has_value() const { return _value.has_value(); }
+
+    T& value() {
+      check(_value.has_value(), "cannot get value of empty binary_extension");
+      return *_value;
+    }
+
+    const T& value() const {
+      check(_value.has_value(), "cannot get value of empty binary_extension");
+      return *_value;
+    }
+
+    template <typename U>
+    T value_or(U&& def) const { return _value.has_value() ? *_value : static_cast<T>(std::forward<U>(def)); }
+    T value_or() const { return _value.has_value() ? *_value : T{}; }
+
+    T* operator->() { return &value(); }
+    const T* operator->() const { return &value(); }
+    T& operator*() { return value(); }
+    const T& operator*() const { return value(); }
+
+    template <typename... Args>
+    binary_extension& emplace(Args&&... args) {
+      _value.emplace(std::forward<Args>(args)...);
+      return *this;
+    }
+
+    void reset() { _value.reset(); }
+
+    friend bool operator==(const binary_extension& a, const binary_extension& b) { return a._value == b._value; }
+
+  private:
+    void store() {
+      if (mock::state().storing && !_value.has_value()) _value.emplace();
+    }
+
+    std::optional<T> _value;
+  };
+
+}
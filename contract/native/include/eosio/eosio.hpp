@@ -0,0 +1,105 @@
+#pragma once
+#include <any>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "name.hpp"
+#include "time.hpp"
+#include "mock.hpp"
+#include "multi_index.hpp"
+
+// === Host-Native eosio === //
+// --- Header-compatible stand-ins for the parts of the CDT the contracts use. --- //
+// --- Chain state lives in eosio::mock; nothing is serialized, but rows are --- //
+// --- stored with their binary_extensions set, as the chain would store them. --- //
+
+#define CONTRACT class [[eosio::contract]]
+#define ACTION [[eosio::action]] void
+#define TABLE struct [[eosio::table]]
+
+// - The CDT provides this at global scope for 128-bit secondary keys
+using uint128_t = unsigned __int128;
+
+namespace eosio {
+
+  // - varuint32; only its value matters on the host
+  struct unsigned_int {
+    uint32_t value = 0;
+
+    unsigned_int(uint32_t v = 0) : value(v) {}
+    template <typename T>
+    operator T() const { return static_cast<T>(value); }
+    unsigned_int& operator=(uint32_t v) {
+      value = v;
+      return *this;
+    }
+
+    friend bool operator==(const unsigned_int& a, const unsigned_int& b) { return a.value == b.value; }
+  };
+
+  // - Action data is passed as arguments on the host, so the stream is never read
+  template <typename T>
+  class datastream {
+  public:
+    datastream() = default;
+    datastream(T start, size_t size) : _start(start), _size(size) {}
+
+  private:
+    T      _start{};
+    size_t _size = 0;
+  };
+
+  struct permission_level {
+    permission_level(name a = {}, name p = {}) : actor(a), permission(p) {}
+    name actor;
+    name permission;
+  };
+
+  // - Inline action; send() appends it to mock::state().actions with its argument tuple
+  struct action {
+    template <typename... Ts>
+    action(const permission_level& auth, name a, name n, const std::tuple<Ts...>& value)
+      : authorization{auth}, account(a), name(n), data(value) {}
+
+    void send() const {
+      mock::state().actions.push_back({account, name, authorization.empty() ? eosio::name{} : authorization[0].actor, data});
+    }
+
+    std::vector<permission_level> authorization;
+    eosio::name                   account;
+    eosio::name                   name;
+    std::any                      data;
+  };
+
+  class contract {
+  public:
+    contract(name self, name first_receiver, datastream<const char*> ds)
+      : _self(self), _first_receiver(first_receiver), _ds(ds) {}
+
+    inline name get_self() const { return _self; }
+    inline name get_first_receiver() const { return _first_receiver; }
+    inline datastream<const char*>& get_datastream() { return _ds; }
+
+  protected:
+    name _self;
+    name _first_receiver;
+    datastream<const char*> _ds;
+  };
+
+  namespace mock {
+
+    // - Runs one action the way the dispatcher does: the contract is built for the action and
+    //   destroyed after it, so anything written back in its destructor lands too. A failed
+    //   check throws check_failure and nothing is rolled back
+    template <typename Contract, typename Action>
+    decltype(auto) apply(name self, name first_receiver, std::initializer_list<name> auths, Action&& act) {
+      set_auth(auths);
+      Contract c(self, first_receiver, datastream<const char*>());
+      return act(c);
+    }
+
+  }
+
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <any>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "name.hpp"
+#include "time.hpp"
+
+// === Host-Native Chain State === //
+// --- What the eosio stand-ins read and write: clock, authorities, accounts, --- //
+// --- inline actions sent, console output and per-operation database counters --- //
+
+namespace eosio {
+
+  // - Thrown by check(); the action aborts as it would on chain
+  struct check_failure : std::runtime_error {
+    using std::runtime_error::runtime_error;
+  };
+
+  inline void check(bool pred, const char* msg) {
+    if (!pred) throw check_failure(msg);
+  }
+
+  inline void check(bool pred, const std::string& msg) {
+    if (!pred) throw check_failure(msg);
+  }
+
+  namespace mock {
+
+    // - Database operations issued through multi_index, as the chain would bill them
+    struct db_counters {
+      uint64_t finds = 0;             // - Primary lookups (find, lower_bound, upper_bound, begin)
+      uint64_t nexts = 0;             // - Iterator steps
+      uint64_t emplaces = 0;
+      uint64_t modifies = 0;
+      uint64_t erases = 0;
+      uint64_t secondary_finds = 0;   // - Secondary index lookups
+      uint64_t secondary_updates = 0; // - Secondary keys stored, re-keyed or removed
+
+      uint64_t total() const {
+        return finds + nexts + emplaces + modifies + erases + secondary_finds + secondary_updates;
+      }
+    };
+
+    // - One inline action, with its arguments kept as the tuple passed to action()
+    struct sent_action {
+      name     account;
+      name     action;
+      name     actor;
+      std::any data;
+    };
+
+    struct chain_state {
+      uint32_t                    now = 1735689600; // - 2025-01-01 00:00:00 UTC
+      std::set<uint64_t>          auths;            // - Accounts that signed the current action
+      std::map<uint64_t, uint32_t> accounts;        // - Existing accounts and their creation time
+      std::vector<sent_action>    actions;
+      std::ostringstream          console;
+      db_counters                 db;
+      std::vector<std::function<void()>> clear_tables; // - One entry per table type in use
+      bool                        storing = false;  // - A row is being written: unset binary_extensions store their default
+      bool                        legacy_rows = false; // - Rows are written as a contract from before their extensions would
+    };
+
+    inline chain_state& state() {
+      static chain_state s;
+      return s;
+    }
+
+    // - Clears every table, account and log; the clock is kept
+    inline void reset() {
+      auto& s = state();
+      for (auto& clear : s.clear_tables) clear();
+      s.auths.clear();
+      s.accounts.clear();
+      s.actions.clear();
+      s.console.str({});
+      s.db = {};
+    }
+
+    // - Held while multi_index copies a row into its table. The chain serializes an unset
+    // - binary_extension as its default, so only a row written without the field stays unset
+    struct storing_row {
+      storing_row() { state().storing = !state().legacy_rows; }
+      ~storing_row() { state().storing = false; }
+    };
+
+    // - Runs writes as a contract from before the extensions: rows keep them unset
+    template <typename Fn>
+    void before_extensions(Fn&& fn) {
+      state().legacy_rows = true;
+      try {
+        fn();
+      } catch (...) {
+        state().legacy_rows = false;
+        throw;
+      }
+      state().legacy_rows = false;
+    }
+
+    inline void set_time(uint32_t sec) { state().now = sec; }
+    inline void add_time(uint32_t sec) { state().now += sec; }
+
+    inline void create_account(name account, uint32_t created = 0) { state().accounts[account.value] = created; }
+
+    // - Replaces the authorities of the next action
+    inline void set_auth(std::initializer_list<name> accounts) {
+      state().auths.clear();
+      for (auto account : accounts) state().auths.insert(account.value);
+    }
+
+  }
+
+  inline time_point current_time_point() { return time_point(seconds(mock::state().now)); }
+
+  inline bool has_auth(name n) { return mock::state().auths.count(n.value) > 0; }
+
+  inline void require_auth(name n) {
+    check(has_auth(n), "missing required authority " + n.to_string());
+  }
+
+  inline bool is_account(name n) { return mock::state().accounts.count(n.value) > 0; }
+
+  template <typename... Args>
+  void print(Args&&... args) {
+    auto& out = mock::state().console;
+    auto put = [&](const auto& arg) {
+      if constexpr (std::is_same_v<std::decay_t<decltype(arg)>, name>) out << arg.to_string();
+      else out << arg;
+    };
+    (put(args), ...);
+  }
+
+}
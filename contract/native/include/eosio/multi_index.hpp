@@ -0,0 +1,312 @@
+#pragma once
+#include <iterator>
+#include <map>
+#include <set>
+#include <tuple>
+#include <utility>
+#include "mock.hpp"
+
+// === Host-Native multi_index === //
+// --- Rows live in memory per (code, table, scope); every operation is counted in mock::state().db --- //
+
+namespace eosio {
+
+  // - Payer that keeps the current one on modify
+  inline constexpr name same_payer{};
+
+  template <typename Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+  struct const_mem_fun {
+    using result_type = Type;
+    Type operator()(const Class& obj) const { return (obj.*PtrToMemberFunction)(); }
+  };
+
+  template <name::raw IndexName, typename Extractor>
+  struct indexed_by {
+    static constexpr uint64_t index_name = static_cast<uint64_t>(IndexName);
+    using secondary_extractor_type = Extractor;
+    using secondary_type = std::decay_t<typename Extractor::result_type>;
+  };
+
+  namespace mock {
+
+    // - Rows of one (code, table, scope) and a (key, primary key) set per secondary index
+    template <typename T, typename... Indices>
+    struct table_data {
+      std::map<uint64_t, T> rows;
+      std::tuple<std::set<std::pair<typename Indices::secondary_type, uint64_t>>...> secondary;
+    };
+
+    template <typename T, typename... Indices>
+    table_data<T, Indices...>& table(uint64_t code, uint64_t table_name, uint64_t scope) {
+      using key = std::tuple<uint64_t, uint64_t, uint64_t>;
+      static std::map<key, table_data<T, Indices...>>* tables = [] {
+        auto* created = new std::map<key, table_data<T, Indices...>>();
+        state().clear_tables.push_back([created] { created->clear(); });
+        return created;
+      }();
+      return (*tables)[key{code, table_name, scope}];
+    }
+
+  }
+
+  template <name::raw TableName, typename T, typename... Indices>
+  class multi_index {
+    using data_t = mock::table_data<T, Indices...>;
+    using rows_t = std::map<uint64_t, T>;
+
+  public:
+    class const_iterator {
+    public:
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const T*;
+      using reference = const T&;
+
+      const_iterator() = default;
+      explicit const_iterator(typename rows_t::const_iterator itr) : _itr(itr) {}
+
+      const T& operator*() const { return _itr->second; }
+      const T* operator->() const { return &_itr->second; }
+
+      const_iterator& operator++() {
+        mock::state().db.nexts++;
+        ++_itr;
+        return *this;
+      }
+      const_iterator operator++(int) {
+        const_iterator copy = *this;
+        ++(*this);
+        return copy;
+      }
+      const_iterator& operator--() {
+        mock::state().db.nexts++;
+        --_itr;
+        return *this;
+      }
+      const_iterator operator--(int) {
+        const_iterator copy = *this;
+        --(*this);
+        return copy;
+      }
+
+      friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._itr == b._itr; }
+      friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._itr != b._itr; }
+
+    private:
+      friend class multi_index;
+      typename rows_t::const_iterator _itr;
+    };
+
+    // - Secondary index in (key, primary key) order, like the chain's tie-break
+    template <size_t I>
+    class index {
+      using index_t = std::tuple_element_t<I, std::tuple<Indices...>>;
+      using key_t = typename index_t::secondary_type;
+      using set_t = std::set<std::pair<key_t, uint64_t>>;
+
+    public:
+      class const_iterator {
+      public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+        const_iterator(const data_t* data, typename set_t::const_iterator itr) : _data(data), _itr(itr) {}
+
+        const T& operator*() const { return _data->rows.at(_itr->second); }
+        const T* operator->() const { return &_data->rows.at(_itr->second); }
+
+        const_iterator& operator++() {
+          mock::state().db.nexts++;
+          ++_itr;
+          return *this;
+        }
+        const_iterator operator++(int) {
+          const_iterator copy = *this;
+          ++(*this);
+          return copy;
+        }
+        const_iterator& operator--() {
+          mock::state().db.nexts++;
+          --_itr;
+          return *this;
+        }
+        const_iterator operator--(int) {
+          const_iterator copy = *this;
+          --(*this);
+          return copy;
+        }
+
+        friend bool operator==(const const_iterator& a, const const_iterator& b) { return a._itr == b._itr; }
+        friend bool operator!=(const const_iterator& a, const const_iterator& b) { return a._itr != b._itr; }
+
+      private:
+        const data_t* _data = nullptr;
+        typename set_t::const_iterator _itr;
+      };
+
+      explicit index(const data_t* data) : _data(data) {}
+
+      const_iterator begin() const { return lookup(keys().begin()); }
+      const_iterator end() const { return const_iterator(_data, keys().end()); }
+
+      const_iterator lower_bound(const key_t& key) const {
+        return lookup(keys().lower_bound({key, 0}));
+      }
+      const_iterator upper_bound(const key_t& key) const {
+        return lookup(keys().upper_bound({key, UINT64_MAX}));
+      }
+      const_iterator find(const key_t& key) const {
+        auto itr = keys().lower_bound({key, 0});
+        return itr != keys().end() && itr->first == key ? lookup(itr) : lookup(keys().end());
+      }
+
+      const_iterator iterator_to(const T& obj) const {
+        return lookup(keys().find({typename index_t::secondary_extractor_type()(obj), obj.primary_key()}));
+      }
+
+    private:
+      const set_t& keys() const { return std::get<I>(_data->secondary); }
+
+      const_iterator lookup(typename set_t::const_iterator itr) const {
+        mock::state().db.secondary_finds++;
+        return const_iterator(_data, itr);
+      }
+
+      const data_t* _data;
+    };
+
+    multi_index(name code, uint64_t scope)
+      : _code(code), _scope(scope), _data(&mock::table<T, Indices...>(code.value, static_cast<uint64_t>(TableName), scope)) {}
+
+    name get_code() const { return _code; }
+    uint64_t get_scope() const { return _scope; }
+
+    const_iterator begin() const {
+      mock::state().db.finds++;
+      return const_iterator(_data->rows.begin());
+    }
+    const_iterator end() const { return const_iterator(_data->rows.end()); }
+
+    const_iterator find(uint64_t pk) const {
+      mock::state().db.finds++;
+      return const_iterator(_data->rows.find(pk));
+    }
+
+    const_iterator lower_bound(uint64_t pk) const {
+      mock::state().db.finds++;
+      return const_iterator(_data->rows.lower_bound(pk));
+    }
+
+    const_iterator upper_bound(uint64_t pk) const {
+      mock::state().db.finds++;
+      return const_iterator(_data->rows.upper_bound(pk));
+    }
+
+    const_iterator require_find(uint64_t pk, const char* error_msg = "unable to find key") const {
+      auto itr = find(pk);
+      check(itr != end(), error_msg);
+      return itr;
+    }
+
+    const T& get(uint64_t pk, const char* error_msg = "unable to find key") const {
+      return *require_find(pk, error_msg);
+    }
+
+    uint64_t available_primary_key() const {
+      return _data->rows.empty() ? 0 : _data->rows.rbegin()->first + 1;
+    }
+
+    template <name::raw IndexName>
+    auto get_index() const {
+      constexpr size_t position = index_position<IndexName>();
+      static_assert(position < sizeof...(Indices), "name provided is not the name of any secondary indices within multi_index");
+      return index<position>(_data);
+    }
+
+    template <typename Lambda>
+    const_iterator emplace(name payer, Lambda&& constructor) {
+      check(payer != name{}, "must specify a valid account to pay for new record");
+      T row{};
+      constructor(row);
+      uint64_t pk = row.primary_key();
+      check(_data->rows.count(pk) == 0, "could not insert object, most likely a uniqueness constraint was violated");
+
+      mock::state().db.emplaces++;
+      mock::storing_row storing;
+      auto itr = _data->rows.emplace(pk, T(row)).first;
+      update_secondary(nullptr, &itr->second);
+      return const_iterator(itr);
+    }
+
+    template <typename Lambda>
+    void modify(const_iterator itr, name payer, Lambda&& updater) {
+      check(itr != end(), "cannot pass end iterator to modify");
+      T& row = const_cast<T&>(itr._itr->second);
+      T before = row;
+      updater(row);
+      check(row.primary_key() == before.primary_key(), "updater cannot change primary key when modifying an object");
+
+      mock::state().db.modifies++;
+      {
+        mock::storing_row storing;
+        row = T(row);
+      }
+      update_secondary(&before, &row);
+    }
+
+    template <typename Lambda>
+    void modify(const T& obj, name payer, Lambda&& updater) {
+      modify(find(obj.primary_key()), payer, std::forward<Lambda>(updater));
+    }
+
+    const_iterator erase(const_iterator itr) {
+      check(itr != end(), "cannot pass end iterator to erase");
+      mock::state().db.erases++;
+      update_secondary(&itr._itr->second, nullptr);
+      return const_iterator(_data->rows.erase(itr._itr));
+    }
+
+    void erase(const T& obj) { erase(find(obj.primary_key())); }
+
+  private:
+    template <name::raw IndexName>
+    static constexpr size_t index_position() {
+      size_t position = 0;
+      bool found = false;
+      ((found || (Indices::index_name == static_cast<uint64_t>(IndexName) ? (found = true) : (position++, false))), ...);
+      return found ? position : sizeof...(Indices);
+    }
+
+    // - Re-keys each secondary index whose key changed (before or after is null on emplace and erase)
+    void update_secondary(const T* before, const T* after) {
+      update_indices(before, after, std::index_sequence_for<Indices...>{});
+    }
+
+    template <size_t... I>
+    void update_indices(const T* before, const T* after, std::index_sequence<I...>) {
+      (update_index<I>(before, after), ...);
+    }
+
+    template <size_t I>
+    void update_index(const T* before, const T* after) {
+      using index_t = std::tuple_element_t<I, std::tuple<Indices...>>;
+      typename index_t::secondary_extractor_type key_of;
+      auto& keys = std::get<I>(_data->secondary);
+
+      if (before != nullptr && after != nullptr && key_of(*before) == key_of(*after)) return;
+      if (before != nullptr) keys.erase({key_of(*before), before->primary_key()});
+      if (after != nullptr) keys.insert({key_of(*after), after->primary_key()});
+      mock::state().db.secondary_updates++;
+    }
+
+    name    _code;
+    uint64_t _scope;
+    data_t* _data;
+  };
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "eosio.hpp"
+
+// === Host-Native Permission Queries === //
+
+namespace eosio {
+
+  inline time_point get_account_creation_time(name account) {
+    auto& accounts = mock::state().accounts;
+    auto itr = accounts.find(account.value);
+    check(itr != accounts.end(), "account does not exist");
+    return time_point(seconds(itr->second));
+  }
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+// === Host-Native eosio Time Types === //
+
+namespace eosio {
+
+  class microseconds {
+  public:
+    constexpr explicit microseconds(int64_t c = 0) : _count(c) {}
+    constexpr int64_t count() const { return _count; }
+    int64_t _count;
+  };
+
+  constexpr microseconds seconds(int64_t s) { return microseconds(s * 1000000); }
+
+  class time_point {
+  public:
+    constexpr explicit time_point(microseconds e = microseconds()) : elapsed(e) {}
+    constexpr const microseconds& time_since_epoch() const { return elapsed; }
+    constexpr uint32_t sec_since_epoch() const { return uint32_t(elapsed.count() / 1000000); }
+    microseconds elapsed;
+  };
+
+  class time_point_sec {
+  public:
+    constexpr time_point_sec() : utc_seconds(0) {}
+    constexpr explicit time_point_sec(uint32_t seconds) : utc_seconds(seconds) {}
+    constexpr time_point_sec(const time_point& t) : utc_seconds(uint32_t(t.time_since_epoch().count() / 1000000)) {}
+
+    constexpr uint32_t sec_since_epoch() const { return utc_seconds; }
+    constexpr operator time_point() const { return time_point(seconds(utc_seconds)); }
+
+    friend constexpr bool operator==(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds == b.utc_seconds; }
+    friend constexpr bool operator!=(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds != b.utc_seconds; }
+    friend constexpr bool operator<(const time_point_sec& a, const time_point_sec& b) { return a.utc_seconds < b.utc_seconds; }
+
+    uint32_t utc_seconds;
+  };
+
+  // - Block time of the mocked chain, see eosio::mock
+  time_point current_time_point();
+
+}
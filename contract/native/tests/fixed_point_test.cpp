@@ -0,0 +1,106 @@
+#include "fixed_point.hpp"
+#include "test_util.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+// === fixed_point Property Tests === //
+// --- Random inputs checked against a 256-bit reference product and the rounding definitions --- //
+
+using namespace fixed_point;
+using test::expect;
+
+namespace {
+
+  // - Full a * b as (high, low) 128-bit halves, from 64-bit limbs
+  struct wide {
+    uint128 high;
+    uint128 low;
+  };
+
+  wide wide_mul(uint128 a, uint128 b) {
+    const uint128 mask = ~uint64_t(0);
+    uint128 a0 = a & mask, a1 = a >> 64, b0 = b & mask, b1 = b >> 64;
+    uint128 p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+
+    uint128 middle = (p00 >> 64) + (p01 & mask) + (p10 & mask);
+    wide result;
+    result.low = (middle << 64) | (p00 & mask);
+    result.high = p11 + (p01 >> 64) + (p10 >> 64) + (middle >> 64);
+    return result;
+  }
+
+  // - Mixes small, 64-bit and full-width values so both fitting and overflowing products come up
+  uint128 sample(std::mt19937_64& rng) {
+    switch (rng() % 4) {
+      case 0: return rng() % 1000;
+      case 1: return rng();
+      case 2: return (uint128(rng()) << 64) | rng();
+      default: return uint128(rng()) << (rng() % 64);
+    }
+  }
+
+}
+
+int main() {
+  std::mt19937_64 rng(20240601);
+  constexpr uint64_t CASES = 200000;
+
+  // - Each power of 10 is ten times the one before, and nothing past 10^18
+  for (uint8_t exp = 1; exp <= MAX_PRECISION; exp++) expect(*pow10(exp) == *pow10(exp - 1) * 10, "pow10 step", exp);
+  for (uint16_t exp = MAX_PRECISION + 1; exp <= UINT8_MAX; exp++) expect(!pow10(exp).has_value(), "pow10 range", exp);
+
+  for (uint64_t i = 0; i < CASES; i++) {
+    uint128 a = sample(rng), b = sample(rng), d = sample(rng);
+
+    // - mul is exact or reports overflow, never wraps
+    wide product = wide_mul(a, b);
+    std::optional<uint128> checked = mul(a, b);
+    expect(checked.has_value() == (product.high == 0), "mul overflow detection", i);
+    if (checked.has_value()) expect(*checked == product.low, "mul value", i);
+
+    // - Rounding: down is the floor, up adds one on any remainder, nearest adds one from half
+    if (d == 0) {
+      expect(!div(a, d).has_value() && !mul_div(a, b, d).has_value(), "zero divisor", i);
+      continue;
+    }
+    uint128 floor = a / d, remainder = a % d;
+    expect(*div(a, d, rounding::down) == floor, "div down", i);
+    expect(*div(a, d, rounding::up) == floor + (remainder != 0), "div up", i);
+    expect(*div(a, d, rounding::nearest) == floor + (remainder >= d - remainder), "div nearest", i);
+    expect(*div(a, d, rounding::down) <= *div(a, d, rounding::nearest) &&
+           *div(a, d, rounding::nearest) <= *div(a, d, rounding::up), "rounding order", i);
+
+    // - mul_div keeps the whole product: the floor times d never passes a * b, one more always does
+    std::optional<uint128> scaled = mul_div(a, b, d);
+    expect(scaled.has_value() == checked.has_value(), "mul_div overflow", i);
+    if (scaled.has_value()) {
+      wide low_side = wide_mul(*scaled, d);
+      wide high_side = wide_mul(*scaled + 1, d);
+      expect(low_side.high == 0 && low_side.low <= *checked, "mul_div floor below", i);
+      expect(high_side.high != 0 || high_side.low > *checked, "mul_div floor above", i);
+    }
+
+    // - Asset amounts stop at MAX_AMOUNT
+    std::optional<int64_t> amount = to_amount(a);
+    expect(amount.has_value() == (a <= uint128(MAX_AMOUNT)), "to_amount range", i);
+    if (amount.has_value()) expect(uint128(*amount) == a, "to_amount value", i);
+  }
+
+  // - Whole tokens and units round-trip at every precision, and units round down to whole tokens
+  for (uint64_t i = 0; i < CASES; i++) {
+    uint8_t precision = rng() % (MAX_PRECISION + 1);
+    uint128 whole = rng() % 1000000000;
+    std::optional<uint128> units = to_units(whole, precision);
+    expect(units.has_value() && *to_whole(*units, precision) == whole, "units round trip", i);
+
+    uint128 extra = rng() % *pow10(precision);
+    expect(*to_whole(*units + extra, precision) == whole, "to_whole rounds down", i);
+    expect(*to_whole(*units + extra, precision, rounding::up) == whole + (extra != 0), "to_whole rounds up", i);
+  }
+
+  // - Fractional rates survive: 7 tokens at 1.50 a day for 3 days is 31.5, paid as 31
+  expect(*mul_div(uint128(7) * 3, 150, 100) == 31, "fractional rate", 0);
+
+  return test::finish("fixed_point: all properties hold");
+}
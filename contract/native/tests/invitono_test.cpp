@@ -0,0 +1,87 @@
+#include "invitono.hpp"
+#include "test_util.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// === invitono Legacy Rows === //
+// --- Rows from before the upline path and counts, written again by this contract --- //
+
+using namespace eosio;
+using test::expect;
+
+namespace {
+
+  const name SELF = "invitono"_n;
+  const name TOKEN = "eosio.token"_n;
+
+  // - Bit 30 of adopter_v2::packed
+  const uint32_t PRUNED = 1u << 30;
+
+  const name a = "a"_n, b = "b"_n, c = "c"_n, d = "d"_n;
+
+  // - Legacy chain a <- b <- c, each row paid by its own user as registeruser stored them,
+  //   then d registers under c: the credit writes c, b and a
+  void setup() {
+    mock::reset();
+    mock::create_account(SELF);
+    mock::create_account(TOKEN);
+    for (name user : {a, b, c, d}) mock::create_account(user);
+    mock::apply<invitono>(SELF, SELF, {SELF}, [&](invitono& contract) {
+      contract.setconfig(SELF, 0, 0, true, 10, 100, TOKEN, symbol("INV", 4), 100);
+    });
+
+    invitono::adopters_table legacy(SELF, SELF.value);
+    mock::before_extensions([&] {
+      legacy.emplace(a, [&](auto& row) { row.account = a; });
+      legacy.emplace(b, [&](auto& row) { row.account = b; row.invitedby = a; });
+      legacy.emplace(c, [&](auto& row) { row.account = c; row.invitedby = b; });
+    });
+    mock::apply<invitono>(SELF, SELF, {d}, [&](invitono& contract) { contract.registeruser(d, c); });
+  }
+
+  // --- Legacy rows written by credits and a claim: backfill and migrate still fill their paths --- //
+  void legacy_paths() {
+    setup();
+
+    // - d's path still reaches the root
+    invitono::adopters_table legacy(SELF, SELF.value);
+    const auto& written = *legacy.find(c.value);
+    expect(written.upline.has_value() && !written.upline->filled, "credited legacy row has no path", 1);
+    expect(written.score == 1, "credited legacy row scored", 2);
+    invitono::adopters2_table compact(SELF, SELF.value);
+    expect(compact.find(d.value)->upline == std::vector<name>{b, a}, "child of a legacy row gets the whole path", 3);
+
+    // - Claimed with only the user's signature, then filled by backfill
+    mock::apply<invitono>(SELF, SELF, {c}, [&](invitono& contract) { contract.claimreward(c); });
+    expect(legacy.find(c.value)->claimed, "legacy row claimed", 4);
+    mock::apply<invitono>(SELF, SELF, {SELF}, [&](invitono& contract) { contract.backfill(name{}, 10); });
+    expect(legacy.find(c.value)->upline->filled && legacy.find(c.value)->upline->ancestors == std::vector<name>{a},
+           "backfill fills a written legacy row", 5);
+
+    // - A row written after backfill loses nothing on the move
+    mock::apply<invitono>(SELF, SELF, {SELF}, [&](invitono& contract) { contract.migrate(10); });
+    const auto* moved = compact.find(c.value) == compact.end() ? nullptr : &*compact.find(c.value);
+    expect(moved != nullptr && (moved->packed & PRUNED) == 0 && moved->upline == std::vector<name>{a}, "migrated row keeps its path", 6);
+    expect(legacy.begin() == legacy.end(), "every row migrated", 7);
+  }
+
+  // --- migrate fills the path of a legacy row written since, without backfill --- //
+  void migrate_written() {
+    setup();
+    mock::apply<invitono>(SELF, SELF, {SELF}, [&](invitono& contract) { contract.migrate(10); });
+
+    invitono::adopters2_table compact(SELF, SELF.value);
+    const auto* moved = compact.find(c.value) == compact.end() ? nullptr : &*compact.find(c.value);
+    expect(moved != nullptr && (moved->packed & PRUNED) == 0 && moved->upline == std::vector<name>{a},
+           "migrate fills a written legacy row", 8);
+  }
+
+}
+
+int main() {
+  legacy_paths();
+  migrate_written();
+
+  return test::finish("invitono: legacy rows keep their paths");
+}
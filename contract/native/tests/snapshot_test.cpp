@@ -0,0 +1,210 @@
+#include "invitono.hpp"
+#include "stakepurple.hpp"
+#include "snapshot_columns.hpp"
+#include "test_util.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+
+// === Snapshot Export Round Trip === //
+// --- Contracts in both layouts, exported page by page, ABI-encoded and decoded back into columns --- //
+
+using namespace eosio;
+using test::account;
+using test::expect;
+
+namespace {
+
+  // - Return values as the chain encodes them: rows as bytes, then the cursor and flags
+  std::vector<char> encode(const std::vector<char>& rows) {
+    std::vector<char> out;
+    uint64_t length = rows.size();
+    do {
+      uint8_t byte = length & 0x7f;
+      length >>= 7;
+      out.push_back(static_cast<char>(byte | (length > 0 ? 0x80 : 0)));
+    } while (length > 0);
+    out.insert(out.end(), rows.begin(), rows.end());
+    return out;
+  }
+
+  std::vector<char> encode(const invitono::export_page& p) {
+    std::vector<char> out = encode(p.rows);
+    snapshot::put(out, p.cursor, 8);
+    out.push_back(p.more);
+    out.push_back(p.settled);
+    return out;
+  }
+
+  std::vector<char> encode(const stakepurple::stake_page& p) {
+    std::vector<char> out = encode(p.rows);
+    snapshot::put(out, static_cast<uint64_t>(p.cursor), 8);
+    snapshot::put(out, static_cast<uint64_t>(p.cursor >> 64), 8);
+    out.push_back(p.more);
+    return out;
+  }
+
+  std::string to_hex(const std::vector<char>& bytes) {
+    static const char* digits = "0123456789abcdef";
+    std::string hex;
+    for (char c : bytes) {
+      hex += digits[static_cast<uint8_t>(c) >> 4];
+      hex += digits[static_cast<uint8_t>(c) & 0xf];
+    }
+    return hex;
+  }
+
+  // - Every page until more is unset, through hex and parse_page like snapshot_decode
+  template <typename Export>
+  snapshot::columns export_all(snapshot::kind type, Export&& call, uint64_t& pages) {
+    snapshot::columns columns(type);
+    auto cursor = decltype(call(0).cursor){0};
+    for (pages = 1;; pages++) {
+      auto result = call(cursor);
+      auto parsed = snapshot::parse_page(*snapshot::from_hex(to_hex(encode(result))), type);
+      expect(parsed.has_value(), "page parses", pages);
+      if (!parsed) break;
+      columns.append(*parsed);
+      if (!result.more) break;
+      cursor = result.cursor;
+    }
+    return columns;
+  }
+
+  // --- invitono: the root in the legacy layout, everyone else registered into the compact one --- //
+  void adopters_round_trip() {
+    const name self = "invitono"_n;
+    const uint64_t ADOPTERS = 300;
+    mock::reset();
+    mock::create_account(self);
+    mock::create_account("eosio.token"_n);
+    mock::apply<invitono>(self, self, {self}, [&](invitono& c) {
+      c.setconfig(self, 0, 0, true, 10, 100, "eosio.token"_n, symbol("INV", 4), 100);
+    });
+
+    std::map<uint64_t, uint64_t> inviters; // - account -> inviter
+    name root = account(0, "a");
+    mock::create_account(root);
+    invitono::adopters_table legacy(self, self.value);
+    legacy.emplace(self, [&](auto& row) { row.account = root; });
+    inviters[root.value] = 0;
+    for (uint64_t i = 1; i < ADOPTERS; i++) {
+      name user = account(i, "a"), inviter = account((i - 1) / 3, "a");
+      mock::create_account(user);
+      mock::apply<invitono>(self, self, {user}, [&](invitono& c) { c.registeruser(user, inviter); });
+      inviters[user.value] = inviter.value;
+    }
+
+    // - Small pages and one big page give the same rows
+    for (uint32_t limit : {7u, snapshot::MAX_PAGE_ROWS}) {
+      uint64_t pages = 0;
+      snapshot::columns columns = export_all(snapshot::kind::adopters, [&](uint64_t cursor) {
+        return mock::apply<invitono>(self, self, {}, [&](invitono& c) { return c.exportadopt(cursor, limit); });
+      }, pages);
+      expect(pages == (ADOPTERS + limit - 1) / limit, "adopter page count", limit);
+
+      const auto& cols = columns.get();
+      expect(columns.rows() == ADOPTERS, "every adopter exported once", limit);
+      auto expected = inviters.begin();
+      for (uint64_t row = 0; row < columns.rows() && expected != inviters.end(); row++, expected++) {
+        name user(cols[0].values[row]);
+        expect(user.value == expected->first, "account order", row);
+        expect(cols[1].values[row] == expected->second, "inviter", row);
+
+        uint32_t score = mock::apply<invitono>(self, self, {}, [&](invitono& c) { return c.getscore(user); });
+        expect(cols[2].values[row] == score, "score", row);
+        expect(cols[3].values[row] == (user == root ? 0 : snapshot::COMPACT), "flags", row);
+      }
+    }
+
+    // - The encoded file carries the header and every column
+    uint64_t pages = 0;
+    snapshot::columns columns = export_all(snapshot::kind::adopters, [&](uint64_t cursor) {
+      return mock::apply<invitono>(self, self, {}, [&](invitono& c) { return c.exportadopt(cursor, 50); });
+    }, pages);
+    std::ostringstream out;
+    columns.write(out);
+    const std::string file = out.str();
+    expect(file.compare(0, 7, "CXCSNAP") == 0, "columns magic", 0);
+    expect(file.size() == 7 + 3 + 8 + 4 * 2 + 7 + 7 + 5 + 5 + ADOPTERS * (8 + 8 + 4 + 4), "columns size", file.size());
+  }
+
+  // --- stakepurple: stakes of several tokens per staker, part migrated to the compact layout --- //
+  void stakes_round_trip() {
+    const name self = "stakepurple"_n, token = "token"_n;
+    const uint64_t STAKERS = 120, TOKENS = 4;
+    // - Slots are interned as stakes migrate, STKD first, so compact stakes are not in symbol code order
+    auto staked_symbol = [](uint64_t i) { return symbol(std::string("STK") + char('D' - i), 4); };
+
+    mock::reset();
+    mock::create_account(self);
+    mock::create_account(token);
+    mock::apply<stakepurple>(self, self, {self}, [&](stakepurple& c) {
+      for (uint64_t i = 0; i < TOKENS; i++) c.setparams(self, staked_symbol(i), token, symbol("RWD", 4), token, 1, 100);
+      c.countstakes(1); // - No stakers yet, so the totals are complete from the start
+    });
+
+    // - Staker i holds the first (i % TOKENS) + 1 tokens
+    std::map<std::pair<uint64_t, uint64_t>, int64_t> stakes; // - (staker, symbol code) -> amount
+    for (uint64_t i = 0; i < STAKERS; i++) {
+      name user = account(i, "s");
+      mock::create_account(user);
+      for (uint64_t t = i % TOKENS + 1; t-- > 0;) {
+        asset quantity(1000'0000 + i, staked_symbol(t));
+        mock::apply<stakepurple>(self, token, {token}, [&](stakepurple& c) { c.on_transfer(user, self, quantity, ""); });
+        stakes[{user.value, quantity.symbol.code().raw()}] = quantity.amount;
+      }
+    }
+    mock::apply<stakepurple>(self, self, {self}, [&](stakepurple& c) { c.migrate(STAKERS); });
+
+    for (uint32_t limit : {3u, snapshot::MAX_PAGE_ROWS}) {
+      uint64_t pages = 0;
+      snapshot::columns columns = export_all(snapshot::kind::stakes, [&](uint128_t cursor) {
+        return mock::apply<stakepurple>(self, self, {}, [&](stakepurple& c) { return c.exportstakes(cursor, limit); });
+      }, pages);
+      expect(pages == (stakes.size() + limit - 1) / limit, "stake page count", limit);
+
+      const auto& cols = columns.get();
+      expect(columns.rows() == stakes.size(), "every stake exported once", limit);
+      auto expected = stakes.begin();
+      for (uint64_t row = 0; row < columns.rows() && expected != stakes.end(); row++, expected++) {
+        symbol sym(cols[1].values[row]);
+        expect(cols[0].values[row] == expected->first.first, "staker order", row);
+        expect(sym.code().raw() == expected->first.second && sym.precision() == 4, "symbol order", row);
+        expect(static_cast<int64_t>(cols[2].values[row]) == expected->second, "amount", row);
+        expect(cols[3].values[row] == mock::state().now, "last_claim", row);
+      }
+    }
+
+    // - Token totals kept by on_transfer agree with the exported stakes
+    std::map<uint64_t, std::pair<int64_t, uint64_t>> totals; // - symbol code -> (amount, stakers)
+    for (const auto& stake : stakes) {
+      totals[stake.first.second].first += stake.second;
+      totals[stake.first.second].second++;
+    }
+    auto page = mock::apply<stakepurple>(self, self, {}, [&](stakepurple& c) { return c.tokenstats(); });
+    expect(page.complete && page.tokens.size() == TOKENS, "token totals complete", page.tokens.size());
+    for (const auto& t : page.tokens) {
+      const auto& expected = totals[t.total_staked.symbol.code().raw()];
+      expect(t.total_staked.amount == expected.first && t.stakers == expected.second, "token totals", t.stakers);
+    }
+  }
+
+}
+
+int main() {
+  adopters_round_trip();
+  stakes_round_trip();
+
+  // - Truncated and malformed pages are rejected, not misread
+  std::vector<char> rows(snapshot::ADOPTER_RECORD_SIZE, 0);
+  std::vector<char> bytes = encode(rows);
+  expect(!snapshot::parse_page(bytes, snapshot::kind::adopters).has_value(), "truncated page", 0);
+  bytes.resize(bytes.size() + 10);
+  expect(snapshot::parse_page(bytes, snapshot::kind::adopters).has_value(), "whole page", 0);
+  expect(!snapshot::parse_page(bytes, snapshot::kind::stakes).has_value(), "wrong kind", 0);
+  expect(!snapshot::from_hex("abc").has_value() && !snapshot::from_hex("zz").has_value(), "bad hex", 0);
+
+  return test::finish("snapshot: exports round-trip");
+}
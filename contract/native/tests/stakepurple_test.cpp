@@ -0,0 +1,563 @@
+#include "stakepurple.hpp"
+#include "test_util.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <random>
+
+// === stakepurple Payouts === //
+// --- Claims checked against rewards computed here from the level series and elapsed time --- //
+
+using namespace eosio;
+using test::account;
+using test::expect;
+using test::fails;
+
+namespace {
+
+  const name SELF = "stakepurple"_n;
+  const name TOKEN = "token"_n;
+
+  // - Reward of one stake held `seconds` at `rate`, with its level bonus
+  int64_t expected_reward(int64_t amount, uint32_t rate, uint64_t seconds) {
+    uint64_t whole = amount / 10000;
+    size_t level = figurate::level(TETRAHEDRAL, whole);
+    return static_cast<int64_t>(whole * (rate + level) * seconds / (100 * 24 * 3600)) + TRIANGULAR[level];
+  }
+
+  using transfer_t = std::tuple<name, name, asset, std::string>;
+  using logclaim_t = std::tuple<name, std::vector<stakepurple::claim_receipt>>;
+
+  // - Inline actions of the last action, split into reward transfers and receipts
+  struct sent {
+    std::vector<std::pair<name, transfer_t>> transfers; // - (token contract, arguments)
+    std::vector<stakepurple::claim_receipt> receipts;
+  };
+
+  sent take_sent() {
+    sent result;
+    for (const auto& a : mock::state().actions) {
+      if (a.action == "transfer"_n) result.transfers.push_back({a.account, std::any_cast<transfer_t>(a.data)});
+      if (a.action == "logclaim"_n) {
+        const auto& receipts = std::get<1>(std::any_cast<const logclaim_t&>(a.data));
+        result.receipts.insert(result.receipts.end(), receipts.begin(), receipts.end());
+      }
+    }
+    mock::state().actions.clear();
+    return result;
+  }
+
+  void stake(name user, const asset& quantity) {
+    mock::apply<stakepurple>(SELF, TOKEN, {TOKEN}, [&](stakepurple& c) { c.on_transfer(user, SELF, quantity, ""); });
+  }
+
+  void claim(name user) {
+    mock::apply<stakepurple>(SELF, SELF, {user}, [&](stakepurple& c) { c.claim(user); });
+  }
+
+  // --- Random multi-token claims: one transfer per reward token, amounts and receipts per stake --- //
+  void random_claims() {
+    struct token_t {
+      symbol staked;
+      name reward_contract;
+      symbol reward;
+      uint32_t rate;
+      uint8_t memo_mode;
+    };
+    // - Two reward contracts and two reward symbols; two pairs are shared, so payouts combine
+    const std::vector<token_t> tokens = {
+      {symbol("STKA", 4), "rewarda"_n, symbol("RWD", 4), 100, MEMO_FULL},
+      {symbol("STKB", 4), "rewarda"_n, symbol("RWD", 4), 250, MEMO_FULL},
+      {symbol("STKC", 4), "rewarda"_n, symbol("BLX", 4), 100, MEMO_COMPACT},
+      {symbol("STKD", 4), "rewardb"_n, symbol("BLX", 4), 300, MEMO_FULL},
+      {symbol("STKE", 4), "rewardb"_n, symbol("BLX", 4), 120, MEMO_EMPTY},
+    };
+    const uint64_t STAKERS = 20, CLAIMS = 200;
+
+    mock::reset();
+    mock::create_account(SELF);
+    mock::create_account(TOKEN);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) {
+      for (const auto& t : tokens) {
+        c.setparams(SELF, t.staked, TOKEN, t.reward, t.reward_contract, 1, t.rate);
+        c.setmemo(t.staked, t.memo_mode);
+      }
+    });
+
+    // - (staker, token) -> (amount, settled at)
+    std::mt19937_64 rng(8);
+    std::map<std::pair<uint64_t, size_t>, std::pair<int64_t, uint32_t>> held;
+    for (uint64_t i = 0; i < STAKERS; i++) {
+      mock::create_account(account(i));
+      for (size_t t = 0; t < tokens.size(); t++) {
+        if (rng() % 2 == 0 && t != i % tokens.size()) continue;
+        int64_t amount = (1 + rng() % 5000) * 10000 + rng() % 10000;
+        stake(account(i), asset(amount, tokens[t].staked));
+        held[{i, t}] = {amount, mock::state().now};
+      }
+    }
+    mock::state().actions.clear();
+
+    for (uint64_t n = 0; n < CLAIMS; n++) {
+      mock::add_time(MIN_CLAIM_INTERVAL + rng() % (3 * 24 * 3600));
+      uint64_t i = rng() % STAKERS;
+      claim(account(i));
+      sent out = take_sent();
+
+      // - Expected payout per reward token, and the stakes whose breakdown is in no memo
+      std::map<std::pair<uint64_t, uint64_t>, int64_t> payouts; // - (contract, symbol) -> amount
+      std::map<std::pair<uint64_t, uint64_t>, uint32_t> stakes_in;
+      for (auto& [key, stake] : held) {
+        if (key.first != i) continue;
+        const token_t& t = tokens[key.second];
+        payouts[{t.reward_contract.value, t.reward.raw()}] += expected_reward(stake.first, t.rate, mock::state().now - stake.second);
+        stakes_in[{t.reward_contract.value, t.reward.raw()}]++;
+      }
+      size_t receipts = 0;
+      for (auto& [key, stake] : held) {
+        if (key.first != i) continue;
+        const token_t& t = tokens[key.second];
+        bool in_memo = t.memo_mode == MEMO_FULL && stakes_in[{t.reward_contract.value, t.reward.raw()}] == 1;
+        if (!in_memo) {
+          receipts++;
+          auto receipt = std::find_if(out.receipts.begin(), out.receipts.end(), [&](const auto& r) { return r.staked_symbol == t.staked; });
+          expect(receipt != out.receipts.end() && receipt->reward.amount == expected_reward(stake.first, t.rate, mock::state().now - stake.second),
+                 "receipt of a stake left out of the memo", n);
+        }
+        stake.second = mock::state().now;
+      }
+
+      expect(out.transfers.size() == payouts.size(), "one transfer per reward token", n);
+      expect(out.receipts.size() == receipts, "receipts only for stakes left out of the memo", n);
+      for (const auto& [contract, args] : out.transfers) {
+        const asset& paid = std::get<2>(args);
+        expect(payouts[{contract.value, paid.symbol.raw()}] == paid.amount, "payout amount", n);
+        expect(std::get<1>(args) == account(i), "payout recipient", n);
+      }
+    }
+  }
+
+  // - Amount of `sym` sent to `user` by the last action
+  int64_t paid(const sent& out, name user, const symbol& sym) {
+    int64_t total = 0;
+    for (const auto& [contract, args] : out.transfers) {
+      if (std::get<1>(args) == user && std::get<2>(args).symbol == sym) total += std::get<2>(args).amount;
+    }
+    return total;
+  }
+
+  const symbol STAKED = symbol("PURPLE", 4);
+  const symbol REWARD = symbol("BLUX", 4);
+  const name REWARD_CONTRACT = "rewards"_n;
+  const uint32_t DAY = 24 * 3600;
+
+  // - Stake written by the contract before checkpoints, so it has none
+  void legacy_stake(name user, const asset& quantity, uint32_t last_claim) {
+    mock::before_extensions([&] {
+      stakepurple::stake_t old_stakes(SELF, user.value);
+      old_stakes.emplace(SELF, [&](auto& row) {
+        row.staked_amount = quantity;
+        row.last_claim = time_point_sec(last_claim);
+      });
+    });
+  }
+
+  // - Config written by the contract before memo modes and the index
+  void legacy_config(const symbol& token, uint32_t rate) {
+    mock::before_extensions([&] {
+      stakepurple::config_t configs(SELF, SELF.value);
+      configs.emplace(SELF, [&](auto& row) {
+        row.creator = SELF;
+        row.token_contract = TOKEN;
+        row.token_symbol = token;
+        row.reward_token_contract = REWARD_CONTRACT;
+        row.reward_token_symbol = REWARD;
+        row.unstake_period = 1;
+        row.reward_rate = rate;
+      });
+    });
+  }
+
+  // - Registers a staker from before the registry and moves its stakes to the compact layout
+  void migrate_legacy(name user) {
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.addstakers({user}); });
+    uint32_t moved = mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { return c.migrate(10); });
+    expect(moved == 1, "legacy stake moved", 35);
+  }
+
+  void setup(uint32_t rate) {
+    mock::reset();
+    mock::create_account(SELF);
+    mock::create_account(TOKEN);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) {
+      c.setparams(SELF, STAKED, TOKEN, REWARD, REWARD_CONTRACT, 1, rate);
+    });
+  }
+
+  // --- Rate change and pause: settled per epoch from the checkpoint; a stake without one is paid by days, once --- //
+  void rate_index() {
+    setup(100);
+    const name indexed = account(0), legacy = account(1);
+    const int64_t amount = 2500 * 10000;
+    const uint64_t whole = 2500;
+    const size_t level = figurate::level(TETRAHEDRAL, whole);
+    mock::create_account(indexed);
+    mock::create_account(legacy);
+    stake(indexed, asset(amount, STAKED));
+
+    // - From before the index: no checkpoint, last claimed when the other stake was made
+    legacy_stake(legacy, asset(amount, STAKED), mock::state().now);
+
+    // - A day at 100, a day at 300, five days paused, half a day at 300
+    mock::add_time(DAY);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.setparams(SELF, STAKED, TOKEN, REWARD, REWARD_CONTRACT, 1, 300); });
+    mock::add_time(DAY);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.pause(true, TOKEN, STAKED); });
+    mock::add_time(5 * DAY);
+    expect(fails([&] { claim(indexed); }), "no claims while paused", 1);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.pause(false, TOKEN, STAKED); });
+    mock::add_time(DAY / 2);
+    mock::state().actions.clear();
+
+    // - getrewards shows what the claim pays, without writing
+    auto pending = mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.getrewards(indexed); });
+    claim(indexed);
+    int64_t per_epoch = whole * (100 * DAY + 300 * DAY + 300 * DAY / 2 + level * (DAY + DAY + DAY / 2)) / (100 * DAY);
+    expect(paid(take_sent(), indexed, REWARD) == per_epoch + int64_t(TRIANGULAR[level]), "indexed stake paid per epoch", 2);
+    expect(pending.size() == 1 && pending[0].reward.amount == per_epoch + int64_t(TRIANGULAR[level]), "getrewards matches the claim", 39);
+
+    // - Seven whole days since the stake, at the current rate, paused days included
+    claim(legacy);
+    expect(paid(take_sent(), legacy, REWARD) == int64_t(whole * 7 * (300 + level) / 100) + TRIANGULAR[level], "stake without a checkpoint paid by days", 3);
+
+    // - The claim left a checkpoint: the next one pays only the time since, per second
+    mock::add_time(DAY / 4);
+    claim(legacy);
+    expect(paid(take_sent(), legacy, REWARD) == expected_reward(amount, 300, DAY / 4), "next claim settles from the new checkpoint", 4);
+  }
+
+  // --- claimbatch over 25 stakers, 7 at a time: each claimable staker paid once --- //
+  void claim_batch() {
+    setup(100);
+    const uint64_t STAKERS = 25;
+    std::vector<int64_t> amounts;
+    for (uint64_t i = 0; i < STAKERS; i++) {
+      mock::create_account(account(i));
+      amounts.push_back((1 + i * 37) * 10000);
+      stake(account(i), asset(amounts[i], STAKED));
+    }
+    mock::add_time(DAY);
+
+    // - One staker leaves the registry, one has just claimed
+    const name emptied = account(3), claimed = account(5);
+    mock::apply<stakepurple>(SELF, SELF, {emptied}, [&](stakepurple& c) { c.unstake(emptied, asset(amounts[3], STAKED)); });
+    claim(claimed);
+    mock::state().actions.clear();
+
+    name cursor;
+    uint32_t calls = 0;
+    sent out;
+    do {
+      cursor = mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { return c.claimbatch(cursor, 7); });
+      sent chunk = take_sent();
+      out.transfers.insert(out.transfers.end(), chunk.transfers.begin(), chunk.transfers.end());
+      calls++;
+    } while (cursor != name() && calls < STAKERS);
+
+    expect(calls == 4, "24 registered stakers in chunks of 7", 5);
+    expect(out.transfers.size() == STAKERS - 2, "one transfer per claimable staker", 6);
+    for (uint64_t i = 0; i < STAKERS; i++) {
+      int64_t expected = i == 3 || i == 5 ? 0 : expected_reward(amounts[i], 100, DAY);
+      expect(paid(out, account(i), REWARD) == expected, "batch payout", 100 + i);
+    }
+  }
+
+  // --- Stakers from before the registry join it on a claim or a top-up, and claimbatch reaches them from then on --- //
+  void legacy_registry() {
+    setup(100);
+    const name claimer = account(0), topped = account(1), idle = account(2);
+    const int64_t amount = 1000 * 10000;
+    for (name user : {claimer, topped, idle}) {
+      mock::create_account(user);
+      legacy_stake(user, asset(amount, STAKED), mock::state().now - DAY);
+    }
+    claim(claimer);
+    stake(topped, asset(amount, STAKED));
+    mock::add_time(DAY);
+    mock::state().actions.clear();
+
+    name cursor = mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { return c.claimbatch(name(), 10); });
+    sent out = take_sent();
+    expect(cursor == name(), "one chunk", 36);
+    expect(paid(out, claimer, REWARD) > 0 && paid(out, topped, REWARD) > 0, "registered by a claim and a top-up", 37);
+    expect(paid(out, idle, REWARD) == 0, "untouched staker not registered", 38);
+  }
+
+  // --- Ledger: top-ups credit, claim folds the credit into its transfer, withdraw pays the rest --- //
+  void ledger() {
+    setup(100);
+    const name user = account(0);
+    const int64_t amount = 1000 * 10000;
+    mock::create_account(user);
+    stake(user, asset(amount, STAKED));
+
+    // - A top-up settles the day so far into the ledger, without a transfer
+    mock::add_time(DAY);
+    stake(user, asset(amount, STAKED));
+    int64_t credited = expected_reward(amount, 100, DAY);
+    expect(take_sent().transfers.empty(), "top-up credits instead of paying", 7);
+
+    // - The claim pays its own reward and the credit in one transfer
+    mock::add_time(DAY);
+    claim(user);
+    sent out = take_sent();
+    expect(out.transfers.size() == 1, "credit folded into the claim transfer", 8);
+    expect(paid(out, user, REWARD) == credited + expected_reward(2 * amount, 100, DAY), "claim pays the credit", 9);
+    expect(fails([&] { mock::apply<stakepurple>(SELF, SELF, {user}, [&](stakepurple& c) { c.withdraw(user); }); }),
+           "nothing left to withdraw after the claim", 10);
+
+    // - A partial unstake credits as well; withdraw pays exactly that, once
+    mock::add_time(DAY);
+    mock::apply<stakepurple>(SELF, SELF, {user}, [&](stakepurple& c) { c.unstake(user, asset(amount, STAKED)); });
+    take_sent();
+    mock::apply<stakepurple>(SELF, SELF, {user}, [&](stakepurple& c) { c.withdraw(user); });
+    expect(paid(take_sent(), user, REWARD) == expected_reward(2 * amount, 100, DAY), "withdraw pays the credit", 11);
+    expect(fails([&] { mock::apply<stakepurple>(SELF, SELF, {user}, [&](stakepurple& c) { c.withdraw(user); }); }),
+           "second withdraw has nothing to pay", 12);
+  }
+
+  // --- Two reward tokens sharing a symbol code are credited, folded and withdrawn side by side --- //
+  void shared_reward_code() {
+    setup(100);
+    const symbol OTHER = symbol("AMBER", 4);
+    const name OTHER_CONTRACT = "rewards.b"_n;
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.setparams(SELF, OTHER, TOKEN, REWARD, OTHER_CONTRACT, 1, 200); });
+    const name user = account(0);
+    const int64_t amount = 500 * 10000;
+    mock::create_account(user);
+    stake(user, asset(amount, STAKED));
+    stake(user, asset(amount, OTHER));
+
+    // - The top-up credits both BLUX tokens instead of failing on the second
+    mock::add_time(DAY);
+    expect(!fails([&] { stake(user, asset(amount, STAKED)); }), "top-up credits both reward tokens", 20);
+    int64_t credited = expected_reward(amount, 100, DAY), other_credited = expected_reward(amount, 200, DAY);
+
+    // - The claim folds each credit into the transfer from its own contract
+    mock::add_time(DAY);
+    claim(user);
+    sent out = take_sent();
+    expect(out.transfers.size() == 2, "one transfer per reward contract", 21);
+    for (const auto& [contract, args] : out.transfers) {
+      int64_t expected = contract == REWARD_CONTRACT ? credited + expected_reward(2 * amount, 100, DAY) : other_credited + expected_reward(amount, 200, DAY);
+      expect(std::get<2>(args).amount == expected, "claim folds the credit of its own contract", 22);
+    }
+
+    // - Unstaking credits both again; withdraw pays each from its contract
+    mock::add_time(DAY);
+    expect(!fails([&] { mock::apply<stakepurple>(SELF, SELF, {user}, [&](stakepurple& c) { c.unstake(user, asset(amount, OTHER)); }); }),
+           "unstake credits both reward tokens", 23);
+    take_sent();
+    mock::apply<stakepurple>(SELF, SELF, {user}, [&](stakepurple& c) { c.withdraw(user); });
+    out = take_sent();
+    expect(out.transfers.size() == 2, "withdraw pays both reward contracts", 24);
+    for (const auto& [contract, args] : out.transfers) {
+      int64_t expected = contract == REWARD_CONTRACT ? expected_reward(2 * amount, 100, DAY) : expected_reward(amount, 200, DAY);
+      expect(std::get<2>(args).amount == expected, "withdraw amount per contract", 25);
+    }
+  }
+
+  // --- Token totals: countstakes in chunks while stakes change, unstakes, and rewards paid --- //
+  void token_totals() {
+    setup(100);
+    const uint64_t STAKERS = 8;
+    const int64_t amount = 300 * 10000;
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.setlog(1000); });
+    for (uint64_t i = 0; i < STAKERS; i++) {
+      mock::create_account(account(i));
+      stake(account(i), asset(amount * (i + 1), STAKED));
+    }
+
+    // - Two stakers from before the registry, which countstakes never visits
+    const name late = account(STAKERS), gone = account(STAKERS + 1);
+    for (name user : {late, gone}) {
+      mock::create_account(user);
+      legacy_stake(user, asset(amount, STAKED), mock::state().now);
+    }
+
+    // - Rewards are counted whether transferred or credited, so after withdrawing everything they match what was sent
+    int64_t sent_rewards = 0;
+    auto collect = [&]() {
+      sent out = take_sent();
+      for (const auto& [contract, args] : out.transfers) {
+        if (std::get<2>(args).symbol == REWARD) sent_rewards += std::get<2>(args).amount;
+      }
+    };
+    auto unstake = [&](uint64_t i, int64_t quantity) {
+      mock::apply<stakepurple>(SELF, SELF, {account(i)}, [&](stakepurple& c) { c.unstake(account(i), asset(quantity, STAKED)); });
+      collect();
+    };
+
+    // - Changes on both sides of the cursor between chunks: counted stakers update the totals,
+    //   the rest are counted as they stand when the cursor reaches them
+    uint32_t calls = 0;
+    bool done = false;
+    while (!done && calls < STAKERS) {
+      mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.countstakes(3); });
+      done = mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.tokenstats(); }).complete;
+      mock::add_time(DAY);
+      uint64_t i = calls++;
+      stake(account(i), asset(amount, STAKED));                 // - top-up
+      collect();
+      unstake((i + 4) % STAKERS, amount / 2);                   // - partial unstake
+      unstake((i + 6) % STAKERS, amount / 2);
+    }
+    expect(done && calls == 3, "countstakes in chunks of 3", 26);
+
+    // - Once counting is done, their first top-up or unstake adds them whole before the change
+    mock::add_time(DAY);
+    stake(late, asset(amount, STAKED));
+    collect();
+    unstake(STAKERS + 1, amount);
+
+    // - Full unstake drops the staker from the count
+    mock::add_time(DAY);
+    auto held = mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.getstakes(account(1)); });
+    if (!held.empty()) unstake(1, held[0].staked_amount.amount);
+    claim(account(2));
+    collect();
+
+    // - Claims write only stakes and totals: nothing logs the token's config
+    auto log = mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.changes(0, 1000); });
+    expect(!log.changes.empty() && std::none_of(log.changes.begin(), log.changes.end(), [](const auto& e) { return e.kind == changelog::CONFIG; }),
+           "no config entries from claims, top-ups or unstakes", 27);
+
+    int64_t staked = 0;
+    uint64_t stakers = 0;
+    for (uint64_t i = 0; i < STAKERS + 2; i++) {
+      for (const auto& row : mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.getstakes(account(i)); })) {
+        staked += row.staked_amount.amount;
+        stakers++;
+      }
+      if (!fails([&] { mock::apply<stakepurple>(SELF, SELF, {account(i)}, [&](stakepurple& c) { c.withdraw(account(i)); }); })) collect();
+    }
+    auto totals = mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.tokenstats(); });
+    expect(totals.complete && totals.tokens.size() == 1, "one token, fully counted", 28);
+    if (totals.tokens.size() == 1) {
+      expect(totals.tokens[0].total_staked.amount == staked, "total staked", 29);
+      expect(totals.tokens[0].stakers == stakers && stakers == STAKERS, "stakers", 30);
+      expect(totals.tokens[0].rewards_paid.amount == sent_rewards && sent_rewards > 0, "rewards paid", 31);
+    }
+  }
+
+  // --- Legacy rows written by this contract keep what they owe: the chain stores an unset extension as its default --- //
+  void legacy_writes() {
+    const int64_t amount = 2500 * 10000;
+
+    // - Moved by migrate: paid its thirteen whole days before the move and the day after
+    setup(100);
+    const name moved = account(0);
+    mock::create_account(moved);
+    legacy_stake(moved, asset(amount, STAKED), mock::state().now - 10 * DAY);
+    mock::add_time(3 * DAY + DAY / 2);
+    migrate_legacy(moved);
+    mock::add_time(DAY);
+    mock::state().actions.clear();
+    claim(moved);
+    expect(paid(take_sent(), moved, REWARD) == expected_reward(amount, 100, 14 * DAY), "migrated stake paid its days", 32);
+
+    // - setmemo on a config from before the index: the index still starts on first use, here the move
+    setup(100);
+    const symbol OLD = symbol("OLDTKN", 4);
+    const name memo = account(1);
+    mock::create_account(memo);
+    legacy_config(OLD, 100);
+    legacy_stake(memo, asset(amount, OLD), mock::state().now - DAY);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.setmemo(OLD, MEMO_COMPACT); });
+    migrate_legacy(memo);
+    mock::add_time(2 * DAY);
+    mock::state().actions.clear();
+    claim(memo);
+    expect(paid(take_sent(), memo, REWARD) == expected_reward(amount, 100, 3 * DAY), "legacy config paid by days after setmemo", 33);
+
+    // - Partial unstake while paused: six whole days kept, then the unpaused day after
+    setup(100);
+    const name paused = account(2);
+    mock::create_account(paused);
+    legacy_stake(paused, asset(2 * amount, STAKED), mock::state().now - 5 * DAY);
+    mock::add_time(DAY / 2);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.pause(true, TOKEN, STAKED); });
+    mock::add_time(DAY / 2);
+    mock::apply<stakepurple>(SELF, SELF, {paused}, [&](stakepurple& c) { c.unstake(paused, asset(amount, STAKED)); });
+    mock::add_time(DAY);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.pause(false, TOKEN, STAKED); });
+    mock::add_time(DAY);
+    mock::state().actions.clear();
+    claim(paused);
+    expect(paid(take_sent(), paused, REWARD) == expected_reward(amount, 100, 7 * DAY), "paused partial unstake keeps its days", 34);
+  }
+
+  // --- getstakes: one list over both layouts, by symbol code --- //
+  void stake_views() {
+    setup(100);
+    const symbol OTHER = symbol("AMBER", 4);
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.setparams(SELF, OTHER, TOKEN, REWARD, REWARD_CONTRACT, 1, 100); });
+    const name user = account(0);
+    mock::create_account(user);
+
+    legacy_stake(user, asset(70000, STAKED), mock::state().now - DAY);
+    stake(user, asset(30000, OTHER));
+
+    auto stakes = mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.getstakes(user); });
+    expect(stakes.size() == 2, "stakes from both layouts", 13);
+    if (stakes.size() == 2) {
+      expect(stakes[0].staked_amount == asset(30000, OTHER) && stakes[0].last_claim.sec_since_epoch() == mock::state().now,
+             "compact stake", 14);
+      expect(stakes[1].staked_amount == asset(70000, STAKED) && stakes[1].last_claim.sec_since_epoch() == mock::state().now - DAY,
+             "legacy stake", 15);
+    }
+    expect(mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.getstakes(account(1)); }).empty(),
+           "no stakes", 16);
+  }
+
+  // --- A token configured before the allowlist is not staked until listtokens lists it --- //
+  void unlisted_token() {
+    setup(100);
+    const symbol OLD = symbol("OLDTKN", 4);
+    legacy_config(OLD, 100);
+    const name user = account(0), spammer = "spam.token"_n;
+    mock::create_account(user);
+    mock::create_account(spammer);
+
+    stake(user, asset(50000, OLD));
+    auto stakes = mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.getstakes(user); });
+    expect(stakes.empty(), "unlisted token is not staked", 17);
+
+    mock::apply<stakepurple>(SELF, SELF, {SELF}, [&](stakepurple& c) { c.listtokens(); });
+    stake(user, asset(50000, OLD));
+    stakes = mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.getstakes(user); });
+    expect(stakes.size() == 1 && stakes[0].staked_amount == asset(50000, OLD), "listed token staked", 18);
+
+    // - Same symbol from another contract is still not a stake
+    mock::apply<stakepurple>(SELF, spammer, {spammer}, [&](stakepurple& c) { c.on_transfer(user, SELF, asset(50000, OLD), ""); });
+    stakes = mock::apply<stakepurple>(SELF, SELF, {}, [&](stakepurple& c) { return c.getstakes(user); });
+    expect(stakes.size() == 1 && stakes[0].staked_amount == asset(50000, OLD), "other contract's token is not staked", 19);
+  }
+
+}
+
+int main() {
+  random_claims();
+  rate_index();
+  claim_batch();
+  legacy_registry();
+  ledger();
+  shared_reward_code();
+  token_totals();
+  legacy_writes();
+  stake_views();
+  unlisted_token();
+
+  return test::finish("stakepurple: payouts match");
+}
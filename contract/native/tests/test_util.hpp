@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <eosio/eosio.hpp>
+
+// === Test Helpers === //
+// --- Failure counting, check() failures and account names shared by the tests and benchmarks --- //
+
+namespace test {
+
+  using namespace eosio;
+
+  // - Failed expectations so far; only the first 20 are printed
+  inline int failures = 0;
+
+  inline void expect(bool ok, const char* what, uint64_t case_no) {
+    if (ok) return;
+    if (failures++ < 20) std::printf("FAIL %s (case %llu)\n", what, static_cast<unsigned long long>(case_no));
+  }
+
+  // - Whether the action aborted through check()
+  inline bool fails(const std::function<void()>& act) {
+    try {
+      act();
+    } catch (const check_failure&) {
+      return true;
+    }
+    return false;
+  }
+
+  // - Valid account name for index i: prefix followed by base-26 letters
+  inline name account(uint64_t i, const std::string& prefix = "u") {
+    std::string str = prefix;
+    do {
+      str += char('a' + i % 26);
+      i /= 26;
+    } while (i > 0);
+    return name(str);
+  }
+
+  // - Exit status for main: the failure count, or `passed` when there were none
+  inline int finish(const char* passed) {
+    if (failures > 0) {
+      std::printf("%d failures\n", failures);
+      return EXIT_FAILURE;
+    }
+    std::printf("%s\n", passed);
+    return EXIT_SUCCESS;
+  }
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "snapshot.hpp"
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// === Snapshot Columns === //
+// --- Export pages, as returned by exportadopt and exportstakes, decoded into one column per field --- //
+
+namespace snapshot {
+
+  // - Columnar file: "CXCSNAP" magic, format version, kind, column count, row count (u64),
+  //   then per column its name (u8 length + chars), value width (u8) and every value little-endian
+  constexpr char COLUMNS_MAGIC[7] = {'C', 'X', 'C', 'S', 'N', 'A', 'P'};
+
+  enum class kind : uint8_t { adopters = 1, stakes = 2 };
+
+  // - ABI-encoded return value of one export action
+  struct page {
+    std::vector<char> rows;
+    bool              more = false;
+  };
+
+  // - Hex text, as in an action trace's return_value_hex_data, to bytes; nullopt on bad input
+  inline std::optional<std::vector<char>> from_hex(const std::string& hex) {
+    auto nibble = [](char c) -> int {
+      if (c >= '0' && c <= '9') return c - '0';
+      if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+      if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+      return -1;
+    };
+    if (hex.size() % 2 != 0) return std::nullopt;
+
+    std::vector<char> bytes;
+    bytes.reserve(hex.size() / 2);
+    for (size_t i = 0; i < hex.size(); i += 2) {
+      int high = nibble(hex[i]), low = nibble(hex[i + 1]);
+      if (high < 0 || low < 0) return std::nullopt;
+      bytes.push_back(static_cast<char>((high << 4) | low));
+    }
+    return bytes;
+  }
+
+  // - rows (varuint32 length + bytes), cursor (8 bytes for adopters, 16 for stakes), more, then
+  //   settled on adopter pages; nullopt when the bytes do not fit that layout
+  inline std::optional<page> parse_page(const std::vector<char>& bytes, kind type) {
+    size_t pos = 0;
+    uint64_t length = 0;
+    for (uint32_t shift = 0;; shift += 7) {
+      if (pos >= bytes.size() || shift > 28) return std::nullopt;
+      uint8_t byte = static_cast<uint8_t>(bytes[pos++]);
+      length |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) break;
+    }
+
+    const size_t record_size = type == kind::adopters ? ADOPTER_RECORD_SIZE : STAKE_RECORD_SIZE;
+    const size_t tail = type == kind::adopters ? 8 + 1 + 1 : 16 + 1;
+    if (length % record_size != 0 || bytes.size() - pos != length + tail) return std::nullopt;
+
+    page result;
+    result.rows.assign(bytes.begin() + pos, bytes.begin() + pos + length);
+    result.more = bytes[pos + length + (type == kind::adopters ? 8 : 16)] != 0;
+    return result;
+  }
+
+  // - Fixed-width values of one field, appended a row at a time
+  struct column {
+    std::string           name;
+    uint8_t               width;
+    std::vector<uint64_t> values;
+  };
+
+  class columns {
+  public:
+    explicit columns(kind type) : _type(type) {
+      if (type == kind::adopters) {
+        _columns = {{"account", 8, {}}, {"inviter", 8, {}}, {"score", 4, {}}, {"flags", 4, {}}};
+      } else {
+        _columns = {{"staker", 8, {}}, {"symbol", 8, {}}, {"amount", 8, {}}, {"last_claim", 4, {}}};
+      }
+    }
+
+    // - Every record of a page, in order
+    void append(const page& p) {
+      const size_t record_size = _type == kind::adopters ? ADOPTER_RECORD_SIZE : STAKE_RECORD_SIZE;
+      for (size_t offset = 0; offset + record_size <= p.rows.size(); offset += record_size) {
+        const char* in = p.rows.data() + offset;
+        if (_type == kind::adopters) {
+          adopter_record row = read_adopter(in);
+          push({row.account, row.inviter, row.score, row.flags});
+        } else {
+          stake_record row = read_stake(in);
+          push({row.staker, row.symbol, static_cast<uint64_t>(row.amount), row.last_claim});
+        }
+      }
+    }
+
+    uint64_t rows() const { return _columns[0].values.size(); }
+    const std::vector<column>& get() const { return _columns; }
+
+    void write(std::ostream& out) const {
+      std::vector<char> bytes(COLUMNS_MAGIC, COLUMNS_MAGIC + sizeof(COLUMNS_MAGIC));
+      put(bytes, VERSION, 1);
+      put(bytes, static_cast<uint8_t>(_type), 1);
+      put(bytes, _columns.size(), 1);
+      put(bytes, rows(), 8);
+      for (const auto& col : _columns) {
+        put(bytes, col.name.size(), 1);
+        bytes.insert(bytes.end(), col.name.begin(), col.name.end());
+        put(bytes, col.width, 1);
+        for (uint64_t value : col.values) put(bytes, value, col.width);
+      }
+      out.write(bytes.data(), bytes.size());
+    }
+
+  private:
+    void push(std::initializer_list<uint64_t> values) {
+      size_t i = 0;
+      for (uint64_t value : values) _columns[i++].values.push_back(value);
+    }
+
+    kind                _type;
+    std::vector<column> _columns;
+  };
+
+}
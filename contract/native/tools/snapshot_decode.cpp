@@ -0,0 +1,57 @@
+#include "snapshot_columns.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// === snapshot_decode === //
+// --- Export pages, one hex return value per line, to a columnar file --- //
+//
+// Usage: snapshot_decode <adopters|stakes> <pages.hex> <out.col>
+//   pages.hex holds the return_value_hex_data of each exportadopt or exportstakes call, in call order
+
+int main(int argc, char** argv) {
+  if (argc != 4 || (std::strcmp(argv[1], "adopters") != 0 && std::strcmp(argv[1], "stakes") != 0)) {
+    std::fprintf(stderr, "usage: %s <adopters|stakes> <pages.hex> <out.col>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  const snapshot::kind type = std::strcmp(argv[1], "adopters") == 0 ? snapshot::kind::adopters : snapshot::kind::stakes;
+
+  std::ifstream in(argv[2]);
+  if (!in) {
+    std::fprintf(stderr, "cannot read %s\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+
+  snapshot::columns columns(type);
+  std::string line;
+  uint64_t line_no = 0;
+  bool more = false;
+  while (std::getline(in, line)) {
+    line_no++;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty()) continue;
+
+    auto bytes = snapshot::from_hex(line);
+    auto page = bytes ? snapshot::parse_page(*bytes, type) : std::nullopt;
+    if (!page) {
+      std::fprintf(stderr, "%s:%llu: not a %s export page\n", argv[2], static_cast<unsigned long long>(line_no), argv[1]);
+      return EXIT_FAILURE;
+    }
+    columns.append(*page);
+    more = page->more;
+  }
+
+  // - A last page with more set means the export stopped early; the file is still written
+  if (more) std::fprintf(stderr, "warning: last page has more rows, export is incomplete\n");
+
+  std::ofstream out(argv[3], std::ios::binary);
+  columns.write(out);
+  if (!out) {
+    std::fprintf(stderr, "cannot write %s\n", argv[3]);
+    return EXIT_FAILURE;
+  }
+  std::printf("%llu %s rows written to %s\n", static_cast<unsigned long long>(columns.rows()), argv[1], argv[3]);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+import { Blockchain } from "@proton/vert";
+import { Name, Serializer } from "@wharfkit/antelope";
+import { expect } from "bun:test";
+import { existsSync, readFileSync, writeFileSync } from "fs";
+
+// per-action cost on the emulator: wall-clock time of the action and the RAM its rows add.
+// vert does not bill CPU, so wall_ms is JS wall-clock time around send(), emulator overhead included;
+// it catches large regressions, not on-chain CPU
+
+export type Measurement = { wall_ms: number; ram_bytes: number; samples: number };
+type Budgets = { [contract: string]: { [action: string]: { wall_ms: number; ram_bytes: number } } };
+
+// budgets are recorded against fresh wasm builds: bun run bench:vert:update builds both contracts first,
+// then commit the budgets.json it writes with the change that moved the costs
+const BUDGETS_FILE = new URL("./budgets.json", import.meta.url).pathname;
+
+// BENCH_UPDATE=1 stores the measured costs as the new budgets instead of checking them
+const UPDATE = process.env.BENCH_UPDATE === "1";
+
+// wall-clock on the emulator is noisy, RAM is exact
+const WALL_HEADROOM = 1.5;
+
+// billable overhead of one table row on chain, on top of its serialized bytes
+const ROW_OVERHEAD = 112;
+
+const budgets: Budgets = existsSync(BUDGETS_FILE) ? JSON.parse(readFileSync(BUDGETS_FILE, "utf8")) : {};
+const measured: Budgets = {};
+
+// seed sizes can be raised for a local soak run, e.g. BENCH_ADOPTERS=50000
+export function scale(env: string, fallback: number) {
+    const value = Number(process.env[env]);
+    return Number.isFinite(value) && value > 0 ? value : fallback;
+}
+
+// serialized bytes of every row the contract stores, in all tables and scopes, plus row overhead
+export function ramBytes(blockchain: Blockchain, code: string) {
+    const contract = blockchain.getAccount(Name.from(code));
+    const abi = contract?.abi;
+    const tables = (blockchain.getStorage() as any)?.[code] ?? {};
+    let bytes = 0;
+    for (const [table, scopes] of Object.entries<{ [scope: string]: unknown[] }>(tables)) {
+        const type = abi?.tables.find(entry => entry.name.toString() === table)?.type;
+        for (const rows of Object.values(scopes)) {
+            for (const row of rows) {
+                bytes += ROW_OVERHEAD + (type ? Serializer.encode({ object: row, abi, type }).array.length : 0);
+            }
+        }
+    }
+    return bytes;
+}
+
+// runs one sample per call of `action` and reports the median time and the mean RAM delta of `code`'s tables
+export async function measure(blockchain: Blockchain, code: string, samples: number, action: (i: number) => Promise<unknown>) {
+    const times: number[] = [];
+    const before = ramBytes(blockchain, code);
+    for (let i = 0; i < samples; i++) {
+        const start = performance.now();
+        await action(i);
+        times.push(performance.now() - start);
+    }
+    const after = ramBytes(blockchain, code);
+
+    times.sort((a, b) => a - b);
+    return { wall_ms: times[Math.floor(times.length / 2)], ram_bytes: Math.round((after - before) / samples), samples } as Measurement;
+}
+
+// fails when a measurement passes its stored budget, or has none; BENCH_UPDATE=1 records instead
+export function checkBudget(contract: string, action: string, measurement: Measurement) {
+    (measured[contract] ??= {})[action] = { wall_ms: measurement.wall_ms, ram_bytes: measurement.ram_bytes };
+    const budget = budgets[contract]?.[action];
+    console.log(
+        `${contract}::${action}`.padEnd(36),
+        `wall ${measurement.wall_ms.toFixed(3)} ms`.padEnd(18),
+        `ram ${measurement.ram_bytes} B`.padEnd(14),
+        budget ? `budget ${budget.wall_ms} ms / ${budget.ram_bytes} B` : "no budget stored"
+    );
+    if (UPDATE) return;
+
+    if (!budget) throw new Error(`no budget for ${contract}::${action}, record one with bun run bench:vert:update`);
+    expect(measurement.wall_ms).toBeLessThanOrEqual(budget.wall_ms);
+    expect(measurement.ram_bytes).toBeLessThanOrEqual(budget.ram_bytes);
+}
+
+// with BENCH_UPDATE=1, writes what this run measured (wall-clock with headroom) over the stored budgets
+export function saveBudgets() {
+    if (!UPDATE) return;
+    // re-read, another bench file may have saved since this one started
+    const merged: Budgets = existsSync(BUDGETS_FILE) ? JSON.parse(readFileSync(BUDGETS_FILE, "utf8")) : {};
+    for (const [contract, actions] of Object.entries(measured)) {
+        for (const [action, cost] of Object.entries(actions)) {
+            (merged[contract] ??= {})[action] = {
+                wall_ms: Number((cost.wall_ms * WALL_HEADROOM).toFixed(3)),
+                ram_bytes: cost.ram_bytes,
+            };
+        }
+    }
+    writeFileSync(BUDGETS_FILE, JSON.stringify(merged, null, 4) + "\n");
+}
@@ -0,0 +1,121 @@
+import { Blockchain, mintTokens, nameToBigInt, symbolCodeToBigInt } from "@proton/vert";
+import { Asset, Name } from "@wharfkit/antelope";
+import { afterAll, beforeAll, describe, test } from "bun:test";
+import { checkBudget, measure, saveBudgets, scale } from "./harness";
+
+// invitono under load: registrations at the bottom of a deep chain and inside a wide tree, then claims
+
+const blockchain = new Blockchain();
+const invitono = blockchain.createContract("invitono", "contract/invitono", true);
+const eosioTokenContract = blockchain.createContract("eosio.token", "node_modules/proton-tsc/external/eosio.token/eosio.token", true);
+
+const DEPTH = scale("BENCH_DEPTH", 50);
+const SAMPLES = scale("BENCH_SAMPLES", 50);
+// claims take the first SAMPLES adopters below the root, registrations the last SAMPLES leaves
+const ADOPTERS = Math.max(scale("BENCH_ADOPTERS", 5000), 2 * SAMPLES + 1);
+const FANOUT = 8;
+const BATCH = 50;
+
+// valid account names: a prefix followed by base-26 letters
+function account(prefix: string, i: number) {
+    let name = prefix;
+    do {
+        name += String.fromCharCode(97 + (i % 26));
+        i = Math.floor(i / 26);
+    } while (i > 0);
+    return name;
+}
+
+const root = "root";
+const chain = Array.from({ length: DEPTH }, (_, i) => account("c", i));
+const tree = Array.from({ length: ADOPTERS }, (_, i) => account("w", i));
+const newcomers = Array.from({ length: 3 * SAMPLES }, (_, i) => account("n", i));
+blockchain.createAccounts(root, ...chain, ...tree, ...newcomers);
+
+const CONFIG = {
+    admin: "invitono",
+    min_age_days: 0,
+    rate_seconds: 0,
+    enabled: true,
+    max_depth: DEPTH,
+    multiplier: 100,
+    token_contract: "eosio.token",
+    reward_symbol: "4,INV",
+    reward_rate: 100,
+};
+
+// registrations signed by the contract, BATCH per action
+async function registerAll(registrations: { user: string; inviter: string }[]) {
+    for (let i = 0; i < registrations.length; i += BATCH) {
+        await invitono.actions.registerbatch({ registrations: registrations.slice(i, i + BATCH) }).send("invitono@active");
+    }
+}
+
+describe("invitono benchmarks", () => {
+    beforeAll(async () => {
+        blockchain.resetTables();
+
+        await mintTokens(eosioTokenContract, "INV", 4, 1e9, 1e3, []);
+        eosioTokenContract.tables["accounts"](invitono.name.value.value).set(
+            // @ts-ignore
+            symbolCodeToBigInt(Asset.SymbolCode.from("INV")),
+            invitono.name,
+            { balance: Asset.fromString("100000000.0000 INV") }
+        );
+
+        // no age limit and no cooldown, so every registration credits every level
+        await invitono.actions.setconfig(CONFIG).send("invitono@active");
+
+        // the root has no inviter, so it is seeded directly in the compact layout
+        invitono.tables["adopters2"](invitono.name.value.value).set(nameToBigInt(Name.from(root)), invitono.name, {
+            account: root,
+            invitedby: "",
+            packed: 0,
+            score: 0,
+            upline: [],
+        });
+
+        // one line DEPTH deep, and a complete FANOUT-ary tree beside it
+        await registerAll(chain.map((user, i) => ({ user, inviter: i === 0 ? root : chain[i - 1] })));
+        await registerAll(tree.map((user, i) => ({ user, inviter: i === 0 ? root : tree[Math.floor((i - 1) / FANOUT)] })));
+    });
+
+    afterAll(() => saveBudgets());
+
+    test("registeruser at the bottom of the chain", async () => {
+        const bottom = chain[chain.length - 1];
+        const result = await measure(blockchain, "invitono", SAMPLES, i =>
+            invitono.actions.registeruser({ user: newcomers[i], inviter: bottom }).send(`${newcomers[i]}@active`)
+        );
+        checkBudget("invitono", "registeruser.deep", result);
+    });
+
+    test("registeruser under the leaves of the tree", async () => {
+        const result = await measure(blockchain, "invitono", SAMPLES, i => {
+            const user = newcomers[SAMPLES + i];
+            const inviter = tree[tree.length - 1 - i];
+            return invitono.actions.registeruser({ user, inviter }).send(`${user}@active`);
+        });
+        checkBudget("invitono", "registeruser.wide", result);
+    });
+
+    test("registeruser at the bottom of the chain during cooldown", async () => {
+        // no score moves, but every ancestor's counts are still rewritten, one row per level
+        await invitono.actions.setconfig({ ...CONFIG, rate_seconds: 86400 }).send("invitono@active");
+        const bottom = chain[chain.length - 1];
+        const result = await measure(blockchain, "invitono", SAMPLES, i => {
+            const user = newcomers[2 * SAMPLES + i];
+            return invitono.actions.registeruser({ user, inviter: bottom }).send(`${user}@active`);
+        });
+        await invitono.actions.setconfig(CONFIG).send("invitono@active");
+        checkBudget("invitono", "registeruser.cooldown", result);
+    });
+
+    test("claimreward across the tree", async () => {
+        const result = await measure(blockchain, "invitono", SAMPLES, i => {
+            const user = tree[1 + i];
+            return invitono.actions.claimreward({ user }).send(`${user}@active`);
+        });
+        checkBudget("invitono", "claimreward", result);
+    });
+});
@@ -0,0 +1,111 @@
+import { Blockchain, mintTokens, symbolCodeToBigInt } from "@proton/vert";
+import { Asset, Name, TimePointSec } from "@wharfkit/antelope";
+import { afterAll, beforeAll, describe, test } from "bun:test";
+import { checkBudget, measure, saveBudgets, scale } from "./harness";
+
+// stakepurple under load: thousands of stakers holding several tokens each, then stakes, top-ups, claims and unstakes
+
+const blockchain = new Blockchain();
+const stakepurple = blockchain.createContract("stakepurple", "contract/stakepurple", true);
+const eosioTokenContract = blockchain.createContract("eosio.token", "node_modules/proton-tsc/external/eosio.token/eosio.token", true);
+
+// three disjoint groups of SAMPLES stakers are measured (top-up, claim, unstake)
+const SAMPLES = scale("BENCH_SAMPLES", 50);
+const STAKERS = Math.max(scale("BENCH_STAKERS", 2000), 3 * SAMPLES);
+const TOKENS = ["STKA", "STKB", "STKC", "STKD"];
+const REWARD = "RWD";
+
+// longer than the claim interval and the unstake period
+const WAIT_SECONDS = 300;
+
+// valid account names: a prefix followed by base-26 letters
+function account(prefix: string, i: number) {
+    let name = prefix;
+    do {
+        name += String.fromCharCode(97 + (i % 26));
+        i = Math.floor(i / 26);
+    } while (i > 0);
+    return name;
+}
+
+const stakers = Array.from({ length: STAKERS }, (_, i) => account("s", i));
+const newcomers = Array.from({ length: SAMPLES }, (_, i) => account("n", i));
+blockchain.createAccounts(...stakers, ...newcomers);
+
+// balances are written straight to the token table, far faster than a transfer each
+function setBalance(owner: Name | string, symbol: string, amount: string) {
+    const name = Name.from(owner);
+    eosioTokenContract.tables["accounts"](name.value.value).set(
+        // @ts-ignore
+        symbolCodeToBigInt(Asset.SymbolCode.from(symbol)),
+        name,
+        { balance: Asset.fromString(`${amount} ${symbol}`) }
+    );
+}
+
+function stake(from: string, quantity: string) {
+    return eosioTokenContract.actions.transfer({ from, to: "stakepurple", quantity, memo: "" }).send(`${from}@active`);
+}
+
+describe("stakepurple benchmarks", () => {
+    beforeAll(async () => {
+        blockchain.resetTables();
+
+        for (const symbol of [...TOKENS, REWARD]) {
+            await mintTokens(eosioTokenContract, symbol, 4, 1e12, 1e3, []);
+        }
+        setBalance(stakepurple.name, REWARD, "100000000.0000");
+
+        for (const symbol of TOKENS) {
+            await stakepurple.actions
+                .setparams({
+                    user: "stakepurple",
+                    token_symbol: `4,${symbol}`,
+                    token_contract: "eosio.token",
+                    reward_token_symbol: `4,${REWARD}`,
+                    reward_token_contract: "eosio.token",
+                    unstake_period: 1,
+                    reward_rate: 100,
+                })
+                .send("stakepurple@active");
+        }
+
+        // every staker holds every token, seeded through the transfer notification like a real stake
+        for (const staker of [...stakers, ...newcomers]) {
+            for (const symbol of TOKENS) setBalance(staker, symbol, "100000.0000");
+        }
+        for (const staker of stakers) {
+            for (const symbol of TOKENS) await stake(staker, `1000.0000 ${symbol}`);
+        }
+
+        blockchain.addTime(TimePointSec.fromInteger(WAIT_SECONDS));
+    });
+
+    afterAll(() => saveBudgets());
+
+    test("on_transfer opening a first stake", async () => {
+        const result = await measure(blockchain, "stakepurple", SAMPLES, i => stake(newcomers[i], `1000.0000 ${TOKENS[0]}`));
+        checkBudget("stakepurple", "on_transfer.new", result);
+    });
+
+    test("on_transfer topping up a staker with every token", async () => {
+        const result = await measure(blockchain, "stakepurple", SAMPLES, i => stake(stakers[i], `10.0000 ${TOKENS[i % TOKENS.length]}`));
+        checkBudget("stakepurple", "on_transfer.topup", result);
+    });
+
+    test("claim by a staker with every token", async () => {
+        const result = await measure(blockchain, "stakepurple", SAMPLES, i => {
+            const user = stakers[SAMPLES + i];
+            return stakepurple.actions.claim({ user }).send(`${user}@active`);
+        });
+        checkBudget("stakepurple", "claim", result);
+    });
+
+    test("unstake part of one token", async () => {
+        const result = await measure(blockchain, "stakepurple", SAMPLES, i => {
+            const user = stakers[2 * SAMPLES + i];
+            return stakepurple.actions.unstake({ user, quantity: `100.0000 ${TOKENS[0]}` }).send(`${user}@active`);
+        });
+        checkBudget("stakepurple", "unstake", result);
+    });
+});
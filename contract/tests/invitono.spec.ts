@@ -0,0 +1,310 @@
+import { Blockchain, mintTokens, nameToBigInt, symbolCodeToBigInt } from "@proton/vert";
+import { Asset, Name, TimePointSec } from "@wharfkit/antelope";
+import { beforeAll, describe, expect, test } from "bun:test";
+import { getTableRows } from "./util";
+
+const blockchain = new Blockchain();
+
+const eagerContract = blockchain.createContract("invite.eager", "contract/invitono", true);
+const lazyContract = blockchain.createContract("invite.lazy", "contract/invitono", true);
+const budgetContract = blockchain.createContract("invite.bdgt", "contract/invitono", true);
+const eosioTokenContract = blockchain.createContract("eosio.token", "node_modules/proton-tsc/external/eosio.token/eosio.token", true);
+
+// deterministic PRNG so a failing tree can be replayed
+function mulberry32(seed: number) {
+    return () => {
+        seed = (seed + 0x6d2b79f5) | 0;
+        let t = Math.imul(seed ^ (seed >>> 15), 1 | seed);
+        t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+        return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+}
+
+// valid account names: "u" followed by base-26 letters
+function userName(i: number) {
+    let name = "u";
+    do {
+        name += String.fromCharCode(97 + (i % 26));
+        i = Math.floor(i / 26);
+    } while (i > 0);
+    return name;
+}
+
+const USERS = 120;
+
+// queued credits a claim replays (invitono::PENDING_READ_LIMIT); longer queues are cranked first
+const PENDING_READ_LIMIT = 25;
+const users = Array.from({ length: USERS }, (_, i) => userName(i));
+blockchain.createAccounts(...users);
+
+// each contract pays in its own symbol so claimers' balances can be compared
+const contracts = [
+    { contract: eagerContract, symbol: "EGR" },
+    { contract: lazyContract, symbol: "LZY" },
+    { contract: budgetContract, symbol: "BGT" },
+];
+
+async function setup() {
+    for (const { contract, symbol } of contracts) {
+        await mintTokens(eosioTokenContract, symbol, 4, 1e9, 1e3, []);
+        eosioTokenContract.tables["accounts"](contract.name.value.value).set(
+            // @ts-ignore
+            symbolCodeToBigInt(Asset.SymbolCode.from(symbol)),
+            contract.name,
+            { balance: Asset.fromString(`1000000.0000 ${symbol}`) }
+        );
+
+        await contract.actions
+            .setconfig({
+                admin: contract.name.toString(),
+                min_age_days: 0,
+                rate_seconds: 60,
+                enabled: true,
+                max_depth: 6,
+                multiplier: 100,
+                token_contract: "eosio.token",
+                reward_symbol: `4,${symbol}`,
+                reward_rate: 100,
+            })
+            .send(`${contract.name}@active`);
+
+        // the first adopter has no inviter, so it is seeded directly
+        contract.tables["adopters"](contract.name.value.value).set(nameToBigInt(Name.from(users[0])), contract.name, {
+            account: users[0],
+            invitedby: "",
+            lastupdated: 0,
+            score: 0,
+            claimed: false,
+        });
+    }
+
+    await lazyContract.actions.setmode({ lazy_scores: true, inline_levels: 0 }).send(`${lazyContract.name}@active`);
+    await budgetContract.actions.setmode({ lazy_scores: false, inline_levels: 2 }).send(`${budgetContract.name}@active`);
+}
+
+describe("invitono lazy and budgeted scores", () => {
+    beforeAll(async () => {
+        blockchain.resetTables();
+        await setup();
+    });
+
+    test("claims and converged scores match the eager path on a random tree", async () => {
+        const random = mulberry32(20240601);
+        const registered = [users[0]];
+        const claimers: string[] = [];
+
+        for (let i = 1; i < USERS; i++) {
+            const inviter = registered[Math.floor(random() * registered.length)];
+            for (const { contract } of contracts) {
+                await contract.actions.registeruser({ user: users[i], inviter }).send(`${users[i]}@active`);
+            }
+            registered.push(users[i]);
+
+            // mix cooldown-blocked and cooldown-passed credits
+            blockchain.addTime(TimePointSec.fromInteger(Math.floor(random() * 90)));
+
+            // drain part of the queues now and then, leave the rest pending
+            if (random() < 0.2) {
+                const max_items = 1 + Math.floor(random() * 5);
+                for (const contract of [lazyContract, budgetContract]) {
+                    await contract.actions.crank({ max_items }).send(`${users[i]}@active`).catch(() => {});
+                }
+            }
+
+            // claims read pending credits on the queued sides, up to the contract's read limit
+            if (random() < 0.1) {
+                const claimer = registered[Math.floor(random() * registered.length)];
+                if (!claimers.includes(claimer)) {
+                    for (const contract of [lazyContract, budgetContract]) {
+                        const queued = getTableRows(blockchain, contract.name.toString(), "credits").length;
+                        if (queued > PENDING_READ_LIMIT) {
+                            await contract.actions.crank({ max_items: queued - PENDING_READ_LIMIT }).send(`${claimer}@active`);
+                        }
+                    }
+                    for (const { contract } of contracts) {
+                        await contract.actions.claimreward({ user: claimer }).send(`${claimer}@active`);
+                    }
+                    claimers.push(claimer);
+                }
+            }
+        }
+
+        // every contract paid each claimer the same reward
+        for (const claimer of claimers) {
+            const balances = getTableRows<{ balance: string }>(blockchain, "eosio.token", "accounts", claimer).map(row => Asset.from(row.balance));
+            const eager = balances.find(balance => balance.symbol.code.toString() === "EGR");
+            for (const symbol of ["LZY", "BGT"]) {
+                const other = balances.find(balance => balance.symbol.code.toString() === symbol);
+                expect(other?.units.toString()).toEqual(eager?.units.toString());
+            }
+        }
+
+        // once drained, both tables are identical to the eager one
+        for (const contract of [lazyContract, budgetContract]) {
+            await contract.actions.crank({ max_items: 100000 }).send(`${users[0]}@active`).catch(() => {});
+            expect(getTableRows(blockchain, contract.name.toString(), "credits")).toEqual([]);
+            for (const table of ["adopters", "adopters2"]) {
+                expect(getTableRows(blockchain, contract.name.toString(), table)).toEqual(getTableRows(blockchain, "invite.eager", table));
+            }
+        }
+    });
+
+    test("migrate moves the seeded row to the compact layout in chunks", async () => {
+        for (const { contract } of contracts) {
+            const before = getTableRows<{ account: string }>(blockchain, contract.name.toString(), "adopters2").length;
+            expect(getTableRows(blockchain, contract.name.toString(), "adopters").length).toEqual(1);
+
+            await contract.actions.migrate({ max_rows: 1 }).send(`${contract.name}@active`);
+            expect(getTableRows(blockchain, contract.name.toString(), "adopters")).toEqual([]);
+            expect(getTableRows(blockchain, contract.name.toString(), "adopters2").length).toEqual(before + 1);
+
+            // the cursor is stored, so a finished migration refuses to run again
+            await expect(contract.actions.migrate({ max_rows: 1 }).send(`${contract.name}@active`)).rejects.toThrow("Migration is complete");
+        }
+    });
+
+    test("leaderboard pages walk every adopter once, highest score first", async () => {
+        type Leader = { account: string; score: number };
+        const pages: Leader[][] = [];
+        for (const { contract } of contracts) {
+            // the snapshot goes live once a refresh pass has visited every adopter
+            const [before] = getTableRows<{ live: number }>(blockchain, contract.name.toString(), "lbstate");
+            for (;;) {
+                await contract.actions.refreshlb({ max_rows: 50 }).send(`${users[0]}@active`);
+                const [state] = getTableRows<{ live: number }>(blockchain, contract.name.toString(), "lbstate");
+                if (Number(state.live) !== Number(before?.live ?? 0)) break;
+            }
+
+            const leaders: Leader[] = [];
+            let after = { after_score: 0, after_account: "" };
+            for (;;) {
+                await contract.actions.leaderboard({ ...after, limit: 7 }).send(`${users[0]}@active`);
+                const page = blockchain.actionTraces[0].returnValue as { leaders: Leader[]; more: boolean };
+                leaders.push(...page.leaders);
+                if (!page.more) break;
+                const last = page.leaders[page.leaders.length - 1];
+                after = { after_score: Number(last.score), after_account: last.account.toString() };
+            }
+            pages.push(leaders);
+        }
+
+        // every adopter exactly once, highest score first
+        expect(pages[0].length).toEqual(USERS);
+        expect(new Set(pages[0].map(leader => leader.account.toString())).size).toEqual(USERS);
+        for (let i = 1; i < pages[0].length; i++) {
+            expect(Number(pages[0][i - 1].score)).toBeGreaterThanOrEqual(Number(pages[0][i].score));
+        }
+        expect(pages[1]).toEqual(pages[0]);
+        expect(pages[2]).toEqual(pages[0]);
+
+        await expect(eagerContract.actions.leaderboard({ after_score: 0, after_account: "", limit: 101 }).send(`${users[0]}@active`)).rejects.toThrow("Invalid limit");
+    });
+
+    test("getuser agrees with the stored row", async () => {
+        const [row] = getTableRows<{ account: string; score: number; claimed: boolean }>(blockchain, "invite.eager", "adopters2").filter(row => row.account.toString() === users[1]);
+        await eagerContract.actions.getuser({ user: users[1] }).send(`${users[1]}@active`);
+        const summary = blockchain.actionTraces[0].returnValue as { score: number; claimed: boolean };
+        expect(Number(summary.score)).toEqual(Number(row.score));
+        expect(summary.claimed).toEqual(row.claimed);
+    });
+
+    test("referral pages and counts follow the invite tree", async () => {
+        type Row = { account: string; invitedby: string; referrals?: { direct: number; downline: number } };
+        for (const { contract } of contracts) {
+            const rows = getTableRows<Row>(blockchain, contract.name.toString(), "adopters2");
+            for (const inviter of users.slice(0, 4)) {
+                const expected = rows.filter(row => row.invitedby.toString() === inviter).map(row => row.account.toString()).sort();
+                const listed: string[] = [];
+                let after = "";
+                for (;;) {
+                    await contract.actions.getreferrals({ inviter, after, limit: 3 }).send(`${users[0]}@active`);
+                    const page = blockchain.actionTraces[0].returnValue as { referrals: { account: string }[]; more: boolean };
+                    listed.push(...page.referrals.map(referral => referral.account.toString()));
+                    if (!page.more) break;
+                    after = listed[listed.length - 1];
+                }
+                expect(listed).toEqual(expected);
+
+                const row = rows.find(row => row.account.toString() === inviter);
+                expect(Number(row?.referrals?.direct ?? 0)).toEqual(expected.length);
+            }
+
+            // the root sees every adopter within max_depth, so at least its direct invites
+            const root = rows.find(row => row.account.toString() === users[0]);
+            expect(Number(root?.referrals?.downline ?? 0)).toBeGreaterThanOrEqual(Number(root?.referrals?.direct ?? 0));
+        }
+    });
+
+    test("sharded stats count every registration", () => {
+        for (const { contract } of contracts) {
+            const shards = getTableRows<{ total_users: number; total_referrals: number }>(blockchain, contract.name.toString(), "statshards");
+            expect(shards.length).toBeGreaterThan(1);
+            expect(shards.reduce((sum, shard) => sum + Number(shard.total_users), 0)).toEqual(USERS - 1);
+            expect(shards.reduce((sum, shard) => sum + Number(shard.total_referrals), 0)).toEqual(USERS - 1);
+        }
+    });
+
+    test("prune leaves scores, counts and stats as on an unpruned contract", async () => {
+        type Row = { account: string; score: number; packed: number; upline: string[]; referrals?: { direct: number; downline: number } };
+        const view = (rows: Row[]) => rows.map(row => [row.account.toString(), Number(row.score), Number(row.referrals?.downline ?? 0)]);
+        const pruned = (rows: Row[]) => rows.filter(row => (Number(row.packed) & 2 ** 30) !== 0);
+
+        // claimers go idle, then only the eager contract prunes
+        blockchain.addTime(TimePointSec.fromInteger(91 * 24 * 3600));
+        await eagerContract.actions.prune({ max_rows: USERS, cursor: "" }).send("invite.eager@active");
+        const rows = getTableRows<Row>(blockchain, "invite.eager", "adopters2");
+        const tombstones = pruned(rows);
+        expect(tombstones.length).toBeGreaterThan(0);
+        expect(tombstones.every(row => row.upline.length === 0)).toBe(true);
+
+        // a second pass finds nothing left to prune
+        await eagerContract.actions.prune({ max_rows: USERS, cursor: "" }).send("invite.eager@active");
+        expect(Number(blockchain.actionTraces[0].returnValue)).toEqual(0);
+
+        // registrations under a tombstone still credit its whole upline
+        const newcomer = userName(USERS);
+        blockchain.createAccounts(newcomer);
+        for (const contract of [eagerContract, lazyContract]) {
+            await contract.actions.registeruser({ user: newcomer, inviter: tombstones[0].account.toString() }).send(`${newcomer}@active`);
+        }
+        await lazyContract.actions.crank({ max_items: 100000 }).send(`${users[0]}@active`).catch(() => {});
+        expect(view(getTableRows<Row>(blockchain, "invite.eager", "adopters2"))).toEqual(view(getTableRows<Row>(blockchain, "invite.lazy", "adopters2")));
+
+        await eagerContract.actions.getstats().send(`${users[0]}@active`);
+        expect(Number((blockchain.actionTraces[0].returnValue as { total_users: number }).total_users)).toEqual(USERS);
+    });
+
+    test("change log lists each changed adopter once per action, within the retention", async () => {
+        type Page = { changes: { seq: number; kind: number; account: string }[]; first_seq: number; next_seq: number; more: boolean };
+        const read = async (since_seq: number, max: number) => {
+            await eagerContract.actions.changes({ since_seq, max }).send(`${users[0]}@active`);
+            return blockchain.actionTraces[0].returnValue as Page;
+        };
+
+        // off until a retention is set
+        const inviter = users[USERS - 1];
+        const first = userName(USERS + 1);
+        blockchain.createAccounts(first);
+        await eagerContract.actions.registeruser({ user: first, inviter }).send(`${first}@active`);
+        expect((await read(0, 100)).changes).toEqual([]);
+
+        // the newcomer and every credited ancestor, each once
+        await eagerContract.actions.setlog({ retention: 20 }).send("invite.eager@active");
+        const second = userName(USERS + 2);
+        blockchain.createAccounts(second);
+        await eagerContract.actions.registeruser({ user: second, inviter: first }).send(`${second}@active`);
+        const page = await read(0, 100);
+        const accounts = page.changes.map(change => change.account.toString());
+        expect(accounts).toContain(second);
+        expect(accounts).toContain(first);
+        expect(new Set(accounts).size).toEqual(accounts.length);
+        expect(Number(page.next_seq)).toEqual(Number(page.first_seq) + accounts.length);
+
+        // a lower retention trims the oldest entries, and polling resumes after since_seq
+        await eagerContract.actions.setlog({ retention: 2 }).send("invite.eager@active");
+        const trimmed = await read(0, 100);
+        expect(trimmed.changes.length).toEqual(2);
+        expect(Number(trimmed.first_seq)).toEqual(Number(page.next_seq) - 2);
+        expect((await read(Number(trimmed.next_seq) - 1, 100)).changes).toEqual([]);
+    });
+});
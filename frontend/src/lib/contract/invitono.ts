@@ -1,4 +1,5 @@
-import { APIClient, Name } from "@wharfkit/session";
+import { APIClient, Serializer } from "@wharfkit/session";
+import { ContractKit } from "@wharfkit/contract";
 import { writable } from "svelte/store";
 
 const TONOMY_CONTRACT_ACCOUNT = "invite.cxc";
@@ -8,7 +9,7 @@ const TONOMY_API_URL = "https://blockchain-api-testnet.tonomy.io";
 export const inviteData = writable<{
     score: number;
     claimed: boolean;
-    lastUpdated: number;
+    cooldownRemaining: number;
 } | null>(null);
 
 // Store for global stats
@@ -32,55 +33,39 @@ export const contractConfig = writable<{
 
 // Initialize API client for Tonomy testnet
 const tonomyApi = new APIClient({ url: TONOMY_API_URL });
+const contractKit = new ContractKit({ client: tonomyApi });
 
-// Fetch user's invite data
+// Call a read-only action and return its result as plain JSON
+async function readOnly(action: string, data: Record<string, unknown> = {}) {
+    const contract = await contractKit.load(TONOMY_CONTRACT_ACCOUNT);
+    return Serializer.objectify(await contract.readonly(action, data));
+}
+
+// Fetch user's invite data (getuser reads both adopter layouts and counts queued credits)
 export async function fetchInviteData(account: string) {
     try {
-        const response = await tonomyApi.v1.chain.get_table_rows({
-            code: TONOMY_CONTRACT_ACCOUNT,
-            scope: TONOMY_CONTRACT_ACCOUNT,
-            table: "adopters",
-            lower_bound: Name.from(account),
-            upper_bound: Name.from(account),
-            limit: 1,
-            json: true
+        const user = await readOnly("getuser", { user: account });
+        inviteData.set({
+            score: Number(user.score),
+            claimed: user.claimed,
+            cooldownRemaining: Number(user.cooldown_remaining)
         });
-
-        if (response.rows.length > 0) {
-            inviteData.set({
-                score: response.rows[0].score,
-                claimed: response.rows[0].claimed,
-                lastUpdated: response.rows[0].lastupdated
-            });
-        } else {
-            inviteData.set(null);
-        }
     } catch (e) {
+        // getuser fails for accounts that are not registered
         console.error("Error fetching invite data:", e);
         inviteData.set(null); // Ensure store is reset on error
     }
 }
 
-// Fetch global stats
+// Fetch global stats (registrations are counted in shards, getstats adds them up)
 export async function fetchGlobalStats() {
     try {
-        const response = await tonomyApi.v1.chain.get_table_rows({
-            code: TONOMY_CONTRACT_ACCOUNT,
-            scope: TONOMY_CONTRACT_ACCOUNT,
-            table: "stats",
-            limit: 1,
-            json: true
+        const stats = await readOnly("getstats");
+        globalStats.set({
+            totalReferrals: Number(stats.total_referrals),
+            totalUsers: Number(stats.total_users),
+            lastRegistered: stats.last_registered
         });
-
-        if (response.rows.length > 0) {
-            globalStats.set({
-                totalReferrals: response.rows[0].total_referrals,
-                totalUsers: response.rows[0].total_users,
-                lastRegistered: response.rows[0].last_registered
-            });
-        } else {
-            globalStats.set(null);
-        }
     } catch (e) {
         console.error("Error fetching global stats:", e);
         globalStats.set(null); // Ensure store is reset on error